@@ -0,0 +1,179 @@
+#ifndef __BATCH_HH__
+#define __BATCH_HH__
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#include "count_paths.hh"
+using namespace std;
+
+// Many grids of one width counted at once.  The states after a row depend
+// only on the rows so far and the next one, so grids that start with the
+// same rows share their sweep down to where they part: the grids form a
+// trie by their rows, every node of it is swept once, and each branch
+// carries on from its parent's states, kept until every branch has taken
+// them.  Work grows with the trie's nodes, the distinct leading row runs
+// across the batch, rather than with grids times rows.  Branches are
+// handed to worker threads; one thread sweeps them depth first.
+struct BatchCounts {
+  vector<uint64_t> counts;  // one per grid, modulo 2^64
+  size_t rows_swept;        // rows swept for the whole batch
+};
+
+template<class ConfigurationT>
+class PrefixSweep {
+  typedef CountSemiring<uint64_t> S;
+  typedef semiring_layer_t<S, ConfigurationT> layer_t;
+
+  // grids that share their rows up to and including row, and the states
+  // before it
+  struct Branch {
+    shared_ptr<const layer_t> states;
+    size_t row;
+    vector<size_t> grids;
+  };
+
+  const vector<Grid> &grids;
+  vector<string> codes;
+  vector<uint64_t> counts;
+  atomic<size_t> rows_swept;
+
+  mutex m;
+  vector<Branch> pending;
+  atomic<size_t> unfinished;
+
+  string row_codes(size_t grid, size_t row) const {
+    const Grid &g = grids[grid];
+    return row < g.rows ? codes[grid].substr(row * g.cols, g.cols) : string();
+  }
+
+  // branches split by their next row, the empty string where it is the last
+  map<string, vector<size_t> > split(const vector<size_t> &members, size_t row) const {
+    map<string, vector<size_t> > parts;
+    for(auto grid : members) {
+      parts[row_codes(grid, row)].push_back(grid);
+    }
+    return parts;
+  }
+
+  // Sweeps the row of branch for every way its grids go on; the ways that
+  // end are counted, the others become branches of their own.
+  void sweep(const Branch &branch, vector<Branch> &children) {
+    vector<Grid::Node::degree_t> target_degrees;
+    vector<vector<Grid::Node> > next_neighbors;
+    for(auto &part : split(branch.grids, branch.row + 1)) {
+      const Grid &g = grids[part.second.front()];
+      row_setup(g, branch.row, target_degrees, next_neighbors);
+      ++rows_swept;
+
+      shared_ptr<layer_t> next_states(new layer_t);
+      for(auto &config_count : *branch.states) {
+	expand_state<S>(branch.row, config_count.first, config_count.second.value, nullptr,
+			target_degrees, next_neighbors,
+			[&](const ConfigurationT &next_config, uint64_t value) {
+			  (*next_states)[next_config].value += value;
+			});
+      }
+
+      if (part.first.empty()) {
+	uint64_t total = 0;
+	for(auto &config_count : *next_states) {
+	  total += config_count.second.value;
+	}
+	for(auto grid : part.second) {
+	  counts[grid] = total;
+	}
+      } else {
+	children.push_back(Branch{next_states, branch.row + 1, move(part.second)});
+      }
+    }
+  }
+
+  void work() {
+    vector<Branch> children;
+    for(;;) {
+      Branch branch;
+      {
+	lock_guard<mutex> lock(m);
+	if (not pending.empty()) {
+	  branch = move(pending.back());
+	  pending.pop_back();
+	}
+      }
+      if (not branch.states) {
+	if (unfinished == 0)
+	  return;
+	this_thread::yield();
+	continue;
+      }
+
+      // depth first down one child, the others to whichever thread is free
+      while (branch.states) {
+	sweep(branch, children);
+	branch = Branch();
+	if (not children.empty()) {
+	  branch = move(children.back());
+	  children.pop_back();
+	  unfinished += children.size();
+	  lock_guard<mutex> lock(m);
+	  for(auto &child : children) {
+	    pending.push_back(move(child));
+	  }
+	}
+	children.clear();
+      }
+      --unfinished;
+    }
+  }
+
+public:
+  PrefixSweep(const vector<Grid> &grids) :
+    grids(grids), counts(grids.size(), 0), rows_swept(0), unfinished(0)
+  {
+    for(auto &g : grids) {
+      codes.push_back(g.codes());
+    }
+  }
+
+  // every grid must be cols wide
+  BatchCounts run(unsigned threads) {
+    shared_ptr<layer_t> initial(new layer_t);
+    if (not grids.empty())
+      (*initial)[ConfigurationT(vector<int>(grids.front().cols, 0))].value = S::one();
+
+    vector<size_t> all;
+    for(auto grid : range(grids.size())) {
+      assert(grids[grid].cols == grids.front().cols);
+      all.push_back(grid);
+    }
+    for(auto &part : split(all, 0)) {
+      pending.push_back(Branch{initial, 0, move(part.second)});
+    }
+    unfinished = pending.size();
+
+    vector<thread> workers;
+    for(unsigned i = 1; i < threads; ++i) {
+      workers.emplace_back([this]() { work(); });
+    }
+    work();
+    for(auto &worker : workers) {
+      worker.join();
+    }
+    return BatchCounts{counts, rows_swept};
+  }
+};
+
+// the layouts of every grid, all of them cols wide
+template<class ConfigurationT>
+BatchCounts count_batch(const vector<Grid> &grids, unsigned threads = 1) {
+  return PrefixSweep<ConfigurationT>(grids).run(threads);
+}
+
+
+#endif
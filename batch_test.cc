@@ -0,0 +1,82 @@
+#include "batch.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <random>
+#include <set>
+#include <sstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+// cols wide grids of random rooms and blocked cells that all start with
+// the same top rows and part at random further down
+vector<Grid> variants(mt19937 &rng, int cols, int rows, int shared, int grids) {
+  vector<int> top(cols * shared);
+  for(auto &cell : top) {
+    cell = rng() % 6 == 0;
+  }
+  top[rng() % top.size()] = 2;
+
+  vector<Grid> out;
+  for(int i = 0; i < grids; ++i) {
+    const int height = shared + 1 + rng() % (rows - shared);
+    vector<int> cells(top);
+    // some variants differ from each other only in their bottom row
+    mt19937 bottom(rng() % 3);
+    for(int cell = cells.size(); cell < cols * height; ++cell) {
+      cells.push_back((cell >= cols * (height - 1) ? rng() : bottom()) % 6 == 0);
+    }
+    cells[cols * (height - 1) + rng() % cols] = 3;
+
+    ostringstream text;
+    text << cols << " " << height;
+    for(auto cell : cells) {
+      text << " " << cell;
+    }
+    out.push_back(parse(text.str()));
+  }
+  return out;
+}
+
+// the rows of the trie of grids: every distinct run of leading rows with
+// the row after it, or the end
+size_t trie_rows(const vector<Grid> &grids) {
+  set<string> rows;
+  for(auto &g : grids) {
+    const string codes = g.codes();
+    for(size_t row = 0; row < g.rows; ++row) {
+      rows.insert(codes.substr(0, min<size_t>(row + 2, g.rows) * g.cols) + (row + 1 == g.rows ? "." : ""));
+    }
+  }
+  return rows.size();
+}
+
+TEST(Batch, counts_every_grid) {
+  mt19937 rng(45);
+  for(int i = 0; i < 40; ++i) {
+    const int cols = 2 + rng() % 5, rows = 3 + rng() % 5;
+    const vector<Grid> grids = variants(rng, cols, rows, 1 + rng() % (rows - 1), 1 + rng() % 12);
+
+    for(unsigned threads : {1, 3}) {
+      const BatchCounts batch = count_batch<VectorConfig>(grids, threads);
+      ASSERT_EQ(grids.size(), batch.counts.size());
+      for(size_t grid = 0; grid < grids.size(); ++grid) {
+	EXPECT_EQ((semiring_paths<CountSemiring<uint64_t>, VectorConfig>(grids[grid])), batch.counts[grid]);
+      }
+      EXPECT_EQ(trie_rows(grids), batch.rows_swept);
+    }
+  }
+}
+
+TEST(Batch, shares_leading_rows) {
+  mt19937 rng(46);
+  const vector<Grid> grids = variants(rng, 5, 8, 6, 10);
+  size_t rows = 0;
+  for(auto &g : grids) {
+    rows += g.rows;
+  }
+  EXPECT_GT(rows / 2, count_batch<VectorConfig>(grids).rows_swept);
+
+  EXPECT_TRUE(count_batch<VectorConfig>(vector<Grid>()).counts.empty());
+}
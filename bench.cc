@@ -0,0 +1,136 @@
+// Times the counting engines against each other.
+//
+//   bench [--counters] [repeat] [grid-file ...]
+//
+// Without grid files it runs hard.quora and a few wider open grids with
+// the intake and the AC in the left column.  Every engine must agree on
+// every grid; the best of `repeat` runs is reported.  With --counters the
+// hash engine's last run is also broken down by sweep phase, see
+// counters.hh.
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "count_paths.hh"
+#include "sort_reduce.hh"
+#include "counters.hh"
+
+using namespace std;
+
+struct Engine {
+  string name;
+  function<long long (const Grid &)> count;
+};
+
+struct Input {
+  string name;
+  string text;
+};
+
+string open_grid(int cols, int rows) {
+  ostringstream os;
+  os << cols << " " << rows << endl;
+  for(auto row : range(rows)) {
+    for(auto col : range(cols)) {
+      os << (col > 0 ? " " : "") << (col > 0 ? 0 : row == 0 ? 2 : row == rows - 1 ? 3 : 0);
+    }
+    os << endl;
+  }
+  return os.str();
+}
+
+int main(int argc, char *argv[]) {
+  const bool counted = argc > 1 and string(argv[1]) == "--counters";
+  if (counted) {
+    --argc;
+    ++argv;
+  }
+  int repeat = argc > 1 ? atoi(argv[1]) : 3;
+  const unsigned threads = thread::hardware_concurrency();
+
+  vector<Input> inputs;
+  vector<string> files;
+  for(int i = 2; i < argc; ++i) {
+    files.push_back(argv[i]);
+  }
+  if (files.empty()) {
+    files.push_back("hard.quora");
+    for(auto size : vector<pair<int, int> >{{8, 8}, {10, 8}, {10, 10}, {11, 9}}) {
+      ostringstream name;
+      name << "open " << size.first << "x" << size.second;
+      inputs.push_back(Input({name.str(), open_grid(size.first, size.second)}));
+    }
+  }
+  for(auto it = files.rbegin(); it != files.rend(); ++it) {
+    ifstream file(*it);
+    if (not file.is_open()) {
+      cerr << "Couldn't open '" << *it << "'" << endl;
+      return 1;
+    }
+    ostringstream text;
+    text << file.rdbuf();
+    inputs.insert(begin(inputs), Input({*it, text.str()}));
+  }
+
+  vector<Engine> engines{
+    {"hash", [](const Grid &g) { return (long long)count_paths<ResizableConfiguration>(g); }},
+    {"sort/1", [](const Grid &g) { return (long long)count_paths_sorted<ResizableConfiguration>(g, 1); }},
+  };
+  if (threads > 1) {
+    ostringstream name;
+    name << "sort/" << threads;
+    engines.push_back(Engine({name.str(), [=](const Grid &g) {
+	    return (long long)count_paths_sorted<ResizableConfiguration>(g, threads);
+	  }}));
+  }
+
+  int status = 0;
+  cout << left << setw(16) << "grid" << setw(12) << "engine"
+       << setw(14) << "count" << "seconds" << endl;
+
+  for(auto &input : inputs) {
+    istringstream is(input.text);
+    Grid g(0, 0);
+    string error;
+    if (not read_grid(is, g, error)) {
+      cerr << input.name << ": " << error << endl;
+      return 1;
+    }
+    long long expected = 0;
+
+    for(auto &engine : engines) {
+      long long result = 0;
+      double best = 0;
+      const bool counting = counted and &engine == &engines[0];
+      for(int i = 0; i < max(repeat, 1); ++i) {
+	if (counting)
+	  counters::start();
+	auto start = chrono::steady_clock::now();
+	result = engine.count(g);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	best = i == 0 ? seconds : min(best, seconds);
+	counters::enabled = false;
+      }
+
+      if (&engine == &engines[0]) {
+	expected = result;
+      } else if (result != expected) {
+	cerr << input.name << ": " << engine.name << " counted " << result
+	     << ", expected " << expected << endl;
+	status = 1;
+      }
+
+      cout << left << setw(16) << input.name << setw(12) << engine.name
+	   << setw(14) << result << fixed << setprecision(4) << best << endl;
+      if (counting)
+	counters::report(cout);
+    }
+  }
+
+  return status;
+}
@@ -0,0 +1,47 @@
+#ifndef __CONFIG_TYPES_HH__
+#define __CONFIG_TYPES_HH__
+
+#include <array>
+#include <vector>
+#include <stdint.h>
+#include "configuration.hh"
+#include "small_vector.hh"
+using namespace std;
+
+// The configuration types the engines are instantiated with, from
+// narrowest to widest.  The fixed ones keep the whole frontier inline in
+// the hash table node; 8 and 16 columns also get the simd kernels, wider
+// ones shrink to byte partners to stay compact.
+typedef Configuration<array<unsigned short, 8>, unsigned short> Max8Configuration;
+typedef Configuration<array<unsigned short, 16>, unsigned short> Max16Configuration;
+typedef Configuration<array<uint8_t, 24>, uint8_t> Max24Configuration;
+typedef Configuration<array<uint8_t, 32>, uint8_t> Max32Configuration;
+typedef Configuration<small_vector<unsigned short, 64>, no_size_t> WideConfiguration;
+typedef Configuration<vector<unsigned short>, no_size_t> ResizableConfiguration;
+
+// Returns action.run<C>() for the smallest configuration type C that
+// holds width columns.
+template<class Action>
+auto with_configuration(size_t width, const Action &action)
+  -> decltype(action.template run<Max8Configuration>())
+{
+  if (width <= 8)
+    return action.template run<Max8Configuration>();
+  if (width <= 16)
+    return action.template run<Max16Configuration>();
+  if (width <= 24)
+    return action.template run<Max24Configuration>();
+  if (width <= 32)
+    return action.template run<Max32Configuration>();
+  return action.template run<WideConfiguration>();
+}
+
+inline const char *configuration_name(size_t width) {
+  return (width <= 8 ? "Max8Configuration" :
+	  width <= 16 ? "Max16Configuration" :
+	  width <= 24 ? "Max24Configuration" :
+	  width <= 32 ? "Max32Configuration" : "WideConfiguration");
+}
+
+
+#endif
@@ -7,11 +7,14 @@
 #include <utility>
 #include <algorithm>
 #include <limits>
+#include <numeric>
 #include <iostream>
 #include <sstream>
 #include <cassert>
 #include <stdint.h>
 #include "range.hh"
+#include "simd.hh"
+#include "small_vector.hh"
 
 using namespace std;
 
@@ -41,18 +44,33 @@ template<class T> struct container_details< vector<T> > {
   }
 };
 
+template<class T, size_t N> struct container_details< small_vector<T,N> > { 
+  static const size_t max_size = numeric_limits< T >::max();
+  static const bool needs_member_size = false;
+
+  template<class C>
+  static void init(C &, small_vector<T,N> & container, size_t count, T const & value) {
+    container.assign(count, value);
+  }
+};
+
 template<class T, size_t N> struct container_details< array<T,N> > {
   static const size_t max_size = N;
   static const bool needs_member_size = true;
 
   template<class C>
   static void init(C &config, array<T,N> & container, size_t count, T const & value) {
-    assert(count < max_size);
+    assert(count <= max_size);
     config._size = count;
-    fill_n(begin(container), count, value);
+    container.fill(value); // unused lanes stay no_partner for the simd kernels
   }
 };
 
+// Containers the simd kernels handle, by their number of lanes.
+template<class T> struct simd_lanes { static const unsigned value = 0; };
+template<> struct simd_lanes< array<unsigned short, 8> > { static const unsigned value = 8; };
+template<> struct simd_lanes< array<unsigned short, 16> > { static const unsigned value = 16; };
+
 template<bool _>
 class index_type {};
  
@@ -111,7 +129,8 @@ struct Configuration {
     };
 
     Configuration c(intify(config_label));
-    swap(*this, c);
+    _size = c._size;
+    config = move(c.config);
     assert(sanity_check());
   }
 
@@ -120,10 +139,11 @@ struct Configuration {
 
 
   // methods
+  // whether every column with a partner is its partner's partner
   bool sanity_check() const {
     for(col_type i : range(size())) {
-      assert((config[i] == no_partner) ||
-	     (config[config[i]] == i));
+      if (config[i] != no_partner and config[config[i]] != i)
+	return false;
     }
 
     return true;
@@ -136,7 +156,9 @@ struct Configuration {
   }
 
   void link(col_type col_a, col_type col_b);
+  void drop(col_type col);
   void mask(vector<bool> mask);
+  void mask(uint32_t keep); // bit col set keeps col; size() <= 32
 
   inline bool link_would_close(col_type col_a, col_type col_b) const {
     assert(sanity_check());
@@ -187,7 +209,9 @@ void Configuration<container_type, size_type, col_type>::link(col_type col_a, co
     config[partner_a] = partner_b;
     config[partner_b] = partner_a;
     config[col_a] = config[col_b] = no_partner;
-    if (partner_a == col_a) {
+    if (partner_a == col_a and partner_b == col_b) {
+      // both ends led to an endpoint: the path is complete
+    } else if (partner_a == col_a) {
       config[partner_b] = partner_b;
     } else if (partner_b == col_b) {
       config[partner_a] = partner_a;
@@ -212,6 +236,17 @@ void Configuration<container_type, size_type, col_type>::link(col_type col_a, co
   assert(sanity_check());
 }
 
+// Ends the path at col: its partner, if any, now leads to an endpoint.
+template <class container_type, class size_type, class col_type>
+void Configuration<container_type, size_type, col_type>::drop(col_type col)
+{
+  col_type partner = config[col];
+  config[col] = no_partner;
+  if (partner != no_partner and partner != col) {
+    config[partner] = partner;
+  }
+}
+
 template <class container_type, class size_type, class col_type>
 void Configuration<container_type, size_type, col_type>::mask(vector<bool> vmask) 
 {
@@ -222,10 +257,26 @@ void Configuration<container_type, size_type, col_type>::mask(vector<bool> vmask
     if (col == no_partner or vmask[col])
       continue;
 
-    col_type partner = config[col];
-    config[col] = no_partner;
-    if (partner != no_partner and partner != col) {
-      config[partner] = partner;
+    drop(col);
+  }
+
+  assert(sanity_check());
+}
+
+
+template <class container_type, class size_type, class col_type>
+void Configuration<container_type, size_type, col_type>::mask(uint32_t keep)
+{
+  assert(sanity_check());
+  assert(size() <= 32);
+
+  const unsigned lanes = simd_lanes<container_type>::value;
+  if (lanes) {
+    simd::kernels().mask((uint16_t *)config.data(), lanes, keep);
+  } else {
+    for(col_type col : range(size())) {
+      if (not (keep & (1u << col)))
+	drop(col);
     }
   }
 
@@ -236,6 +287,11 @@ void Configuration<container_type, size_type, col_type>::mask(vector<bool> vmask
 template <class container_type, class size_type, class col_type>
 inline bool operator==(const Configuration<container_type, size_type, col_type> &a, 
 		       const Configuration<container_type, size_type, col_type> &b) {
+  const unsigned lanes = simd_lanes<container_type>::value;
+  if (lanes) {
+    return simd::kernels().equal((const uint16_t *)a.config.data(),
+				 (const uint16_t *)b.config.data(), lanes);
+  }
   return a.config == b.config;
 }
 
@@ -286,10 +342,14 @@ namespace std {
   template <class container_type, class size_type, class col_type>
   struct hash<Configuration<container_type, size_type, col_type> > {
     inline size_t operator()(const Configuration<container_type, size_type, col_type> &config ) const {
+      const unsigned lanes = simd_lanes<container_type>::value;
+      if (lanes) {
+	return simd::kernels().hash((const uint16_t *)config.config.data(), lanes);
+      }
       return accumulate(begin(config.config), end(config.config), 
 			hash<size_t>()(config.config.size()),
 			[&](size_t so_far, col_type partner) {
-			  return so_far ^ partner;
+			  return (so_far ^ partner) * 0x9e3779b97f4a7c15ull;
 			});		      
     };
   };
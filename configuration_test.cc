@@ -1,8 +1,14 @@
 #include "configuration.hh"
+#include "packed.hh"
+#include "config_types.hh"
+#include "count_paths.hh"
 #include "gtest/gtest.h"
+#include "test_grids.hh"
 
+#include <sstream>
 #include <vector>
 #include <utility>
+#include <random>
 #include <iostream>
 #include "vector_out.hh"
 using namespace std;
@@ -10,8 +16,9 @@ using namespace std;
 typedef pair<int, int> link_t;
 typedef tuple<int, int, string> masked_link_t;
 
-typedef  Configuration<vector<unsigned short>, no_size_t> VectorConfig;
 typedef  Configuration<array<unsigned short, 8>, unsigned short> ArrayConfig;
+typedef  Configuration<array<uint8_t, 24>, uint8_t> ByteConfig;
+typedef  Configuration<small_vector<unsigned short, 4>, no_size_t> SmallVectorConfig;
 
 
 
@@ -74,11 +81,14 @@ TEST(ArrayConfig, link) {
     test_t{"10220", {{0,1}, {3,4}}, "01202"},
     test_t{"1234432", {{2,3}, {5,6}}, "1200200"},
     test_t{"1202", {{0,1}}, "0001"},
+    test_t{"1020", {{0,2}}, "0000"},
   };
 
   for(auto t : tests) {
     test_ops<VectorConfig>(t);
     test_ops<ArrayConfig>(t);
+    test_ops<ByteConfig>(t);
+    test_ops<SmallVectorConfig>(t);
   }
 }
 
@@ -93,5 +103,161 @@ TEST(ArrayConfig, mask) {
   for(auto t : tests) {
     test_ops<VectorConfig>(t);
     test_ops<ArrayConfig>(t);
+    test_ops<ByteConfig>(t);
+    test_ops<SmallVectorConfig>(t);
+  }
+}
+
+TEST(ArrayConfig, drop) {
+  for(auto t : vector<tuple<string, int, string> > {
+      make_tuple("1221", 0, "0112"),
+      make_tuple("1020", 2, "1000"),
+      make_tuple("0110", 0, "0110"),
+    }) {
+    VectorConfig v(get<0>(t));
+    ArrayConfig a(get<0>(t));
+    v.drop(get<1>(t));
+    a.drop(get<1>(t));
+    EXPECT_EQ(get<2>(t), v.tostring());
+    EXPECT_EQ(get<2>(t), a.tostring());
+  }
+}
+
+TEST(ArrayConfig, pack) {
+  for(string label : {"0000", "1221", "1020", "12213", "0120210", "1234432"}) {
+    VectorConfig v(label);
+    ArrayConfig a(label);
+    packed_config_t key = pack_configuration(v);
+    EXPECT_EQ(key, pack_configuration(a));
+    EXPECT_EQ(label, unpack_configuration<VectorConfig>(key, label.size()).tostring());
+    EXPECT_EQ(label, unpack_configuration<ArrayConfig>(key, label.size()).tostring());
+  }
+}
+
+typedef Configuration<array<unsigned short, 16>, unsigned short> Array16Config;
+
+// random non-crossing configurations of the given width
+string random_label(mt19937 &rng, size_t width) {
+  string label(width, '0');
+  vector<size_t> open;
+  int next = 1;
+  for(size_t col = 0; col < width; ++col) {
+    switch(rng() % 4) {
+    case 1:
+      open.push_back(col);
+      break;
+    case 2:
+      if (not open.empty()) {
+	label[open.back()] = label[col] = '0' + next++;
+	open.pop_back();
+      }
+      break;
+    case 3:
+      label[col] = '0' + next++;
+      break;
+    }
+  }
+  return label;
+}
+
+template<class C>
+void check_kernels(const simd::Kernels &kernels, size_t width) {
+  mt19937 rng(width);
+  for(int i = 0; i < 500; ++i) {
+    C c(random_label(rng, width));
+    const uint32_t keep = rng();
+    const unsigned lanes = simd_lanes<decltype(c.config)>::value;
+    uint16_t *data = (uint16_t *)c.config.data();
+
+    // scalar Configuration code is the reference
+    C expected(c);
+    vector<bool> mask_bool(width);
+    for(auto col : range(width)) {
+      mask_bool[col] = keep & (1u << col);
+    }
+    expected.mask(mask_bool);
+
+    EXPECT_EQ(simd::scalar_kernels.pack(data, lanes), kernels.pack(data, lanes));
+    C copy(c);
+    EXPECT_EQ(kernels.hash(data, lanes), kernels.hash((uint16_t *)copy.config.data(), lanes));
+
+    C masked(c);
+    kernels.mask((uint16_t *)masked.config.data(), lanes, keep);
+    EXPECT_TRUE(masked.sanity_check());
+    EXPECT_TRUE(expected.config == masked.config);
+    EXPECT_TRUE(kernels.equal((uint16_t *)expected.config.data(),
+			      (uint16_t *)masked.config.data(), lanes));
+    EXPECT_EQ(c.config == masked.config,
+	      kernels.equal(data, (uint16_t *)masked.config.data(), lanes));
+  }
+}
+
+TEST(ArrayConfig, simd_kernels) {
+  vector<const simd::Kernels *> available{&simd::scalar_kernels};
+  if (simd::have_sse42())
+    available.push_back(&simd::sse42_kernels);
+  if (simd::have_avx2())
+    available.push_back(&simd::avx2_kernels);
+
+  for(auto kernels : available) {
+    for(size_t width : {1, 4, 7}) {
+      check_kernels<ArrayConfig>(*kernels, width);
+    }
+    for(size_t width : {8, 12, 15}) {
+      check_kernels<Array16Config>(*kernels, width);
+    }
+  }
+}
+
+TEST(ArrayConfig, mask_bits) {
+  mt19937 rng(7);
+  for(int i = 0; i < 200; ++i) {
+    string label = random_label(rng, 7);
+    const uint32_t keep = rng();
+    vector<bool> mask_bool(label.size());
+    for(auto col : range(label.size())) {
+      mask_bool[col] = keep & (1u << col);
+    }
+
+    VectorConfig by_vector(label), by_bits(label);
+    ArrayConfig simd(label);
+    by_vector.mask(mask_bool);
+    by_bits.mask(keep);
+    simd.mask(keep);
+    EXPECT_EQ(by_vector.tostring(), by_bits.tostring());
+    EXPECT_EQ(by_vector.tostring(), simd.tostring());
+    EXPECT_EQ(pack_configuration(by_vector), pack_configuration(simd));
+  }
+}
+
+TEST(ArrayConfig, full_width) {
+  // a fixed configuration may use every one of its columns
+  Max8Configuration c("12213443");
+  EXPECT_EQ("12213443", c.tostring());
+  c.link(3, 4);
+  EXPECT_EQ("12200331", c.tostring());
+}
+
+template<class C>
+struct CountWith {
+  const Grid &g;
+  template<class D> pair<int, string> run() const {
+    return make_pair(count_paths<D>(g), string(configuration_name(g.cols)));
+  }
+};
+
+TEST(ConfigTypes, agree_with_vector) {
+  for(int cols : {8, 9, 16, 17, 24, 25, 32, 33, 40}) {
+    // along the top row, then down into the AC; the rest is not ours
+    ostringstream text;
+    text << cols << " 2 2";
+    for(int i = 1; i < 2 * cols; ++i) {
+      text << " " << (i < cols ? 0 : i == 2 * cols - 1 ? 3 : 1);
+    }
+    Grid g = parse(text.str());
+
+    auto result = with_configuration(g.cols, CountWith<VectorConfig>{g});
+    EXPECT_EQ(count_paths<VectorConfig>(g), result.first) << result.second;
+    EXPECT_EQ(1, result.first) << cols;
   }
 }
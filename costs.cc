@@ -0,0 +1,60 @@
+#include "costs.hh"
+
+#include "range.hh"
+
+CostGrid::CostGrid(size_t rows, size_t cols) :
+  rows(rows),
+  cols(cols),
+  cell(rows * cols, 0),
+  right(rows * cols, 0),
+  down(rows * cols, 0),
+  valid(true)
+{}
+
+CostGrid::CostGrid(istream &is, size_t grid_rows, size_t grid_cols) :
+  rows(0),
+  cols(0),
+  valid(false)
+{
+  // the size is checked before anything of that size is allocated
+  if (not (is >> cols >> rows) or rows == 0 or cols == 0 or rows != grid_rows or cols != grid_cols)
+    return;
+
+  CostGrid c(rows, cols);
+
+  for(auto row : range(rows)) {
+    for(auto col : range(cols)) {
+      is >> c.cell[row * cols + col];
+    }
+  }
+  if (not is)
+    return;
+
+  // the segment costs are all there or not at all
+  vector<cost_t> segments;
+  cost_t cost;
+  while (is >> cost) {
+    segments.push_back(cost);
+  }
+  if (not is.eof())
+    return;
+
+  if (not segments.empty()) {
+    if (segments.size() != rows * (cols - 1) + (rows - 1) * cols)
+      return;
+
+    auto next = begin(segments);
+    for(auto row : range(rows)) {
+      for(auto col : range(cols - 1)) {
+	c.right[row * cols + col] = *next++;
+      }
+    }
+    for(auto row : range(rows - 1)) {
+      for(auto col : range(cols)) {
+	c.down[row * cols + col] = *next++;
+      }
+    }
+  }
+
+  *this = c;
+}
@@ -0,0 +1,34 @@
+#ifndef __COSTS_HH__
+#define __COSTS_HH__
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+typedef long long cost_t;
+
+// Installation costs for the cells and duct segments of a grid.  The text
+// format follows the grid file:
+//
+//   W H
+//   H rows of W cell costs
+//   H rows of W-1 costs of the segments to the right      (optional)
+//   H-1 rows of W costs of the segments downwards         (optional)
+//
+// Missing segment costs are zero.  Every room is on every layout, so the
+// cell costs only shift the total; the segments are what layouts differ in.
+struct CostGrid {
+  size_t rows, cols;
+  vector<cost_t> cell, right, down;  // row-major, rows * cols each
+  bool valid;                        // false if the file is not rows x cols or cut short
+
+  CostGrid(size_t rows, size_t cols);  // all zero
+  CostGrid(istream &is, size_t rows, size_t cols);  // the costs of a rows x cols grid
+
+  cost_t cell_cost(size_t row, size_t col) const { return cell[row * cols + col]; }
+  cost_t right_cost(size_t row, size_t col) const { return right[row * cols + col]; }
+  cost_t down_cost(size_t row, size_t col) const { return down[row * cols + col]; }
+};
+
+
+#endif
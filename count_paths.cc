@@ -1,220 +1,499 @@
 #include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <algorithm>
+#include <random>
+#include <functional>
 #include <iterator>
-#include <vector>
-#include <unordered_map>
-
-#include "configuration.hh"
-#include "grid.hh"
-#include "combinations.hh"
-#include "range.hh"
-#include "vector_out.hh"
+#include <map>
+#include <memory>
+
+#include "count_paths.hh"
+#include "sort_reduce.hh"
+#include "options.hh"
+#include "zdd.hh"
+#include "graph.hh"
+#include "ordering.hh"
+#include "page_alloc.hh"
+#include "result_cache.hh"
+#include "planner.hh"
+#include "decompose.hh"
+#include "transfer.hh"
+#include "sharded.hh"
+#include "dfs.hh"
+#include "symmetry.hh"
+#include "grid_file.hh"
+#include "histogram.hh"
+#include "batch.hh"
+#include "estimate.hh"
 
 using namespace std;
 
-typedef Configuration<vector<unsigned short>, no_size_t> ResizableConfiguration;
-typedef Configuration<array<unsigned short, 8>, unsigned short> Max8Configuration;
 
+template<typename F>
+void repeat(size_t times, F action) {
+  for(size_t i = times; i != 0; --i) 
+    action();
+}
+
+struct BuildZdd {
+  const FrontierPlan &plan;
+  template<class C> Zdd run() const { return build_zdd<C>(plan); }
+};
 
-void row_setup(Grid g, Grid::Node::ordinate_t row, 
-	       vector<Grid::Node::degree_t> &target_degrees, 
-	       vector< vector<Grid::Node> > &next_neighbors) 
-{
-  target_degrees.clear();
-  next_neighbors.clear();
+struct CountFrontierPaths {
+  const FrontierPlan &plan;
+  const Options &options;
+  template<class C> uint64_t run() const {
+    uint64_t total = 0;
+    repeat(options.repeat, [&]{total = count_frontier_paths<C>(plan);});
+    return total;
+  }
+};
 
-  for(Grid::Node::ordinate_t col : range(g.cols)) {
-    target_degrees.emplace_back(g.target_degree(row, col));
+struct CountGridPaths {
+  const Grid &g;
+  const Options &options;
+  SweepControl *control;
+  template<class C> int run() const {
+    int total = 0;
+    if (control) {
+      total = semiring_paths<CountSemiring<unsigned int>, C>(g, nullptr, nullptr, control);
+    } else if (options.aggregate == "sort" and g.cols <= max_packed_cols) {
+      repeat(options.repeat, [&]{total = count_paths_sorted<C>(g, options.threads);});
+    } else {
+      repeat(options.repeat, [&]{total = count_paths<C>(g);});
+    }
+    return total;
+  }
+};
 
-      vector<Grid::Node> next_neighbors_col;
-      for(Grid::Node neighbor : g.neighbors(row, col)) {
-	if (neighbor.row > row or (neighbor.row == row and neighbor.col > col)) {
-	  next_neighbors_col.push_back(neighbor);
-	}
-      }
+struct CountPowered {
+  const Grid &g;
+  const Options &options;
+  template<class C> uint64_t run() const {
+    uint64_t total = 0;
+    repeat(options.repeat, [&]{total = count_paths_powered<C>(g, options.modulus);});
+    return total;
+  }
+};
+
+struct CountMirrored {
+  const Grid &g;
+  const Options &options;
+  template<class C> uint64_t run() const {
+    uint64_t total = 0;
+    repeat(options.repeat, [&]{total = count_paths_mirrored<C>(g);});
+    return total;
+  }
+};
+
+struct CountHistogram {
+  const Grid &g;
+  layout_statistic_t statistic;
+  template<class C> vector<uint64_t> run() const { return layout_histogram<C>(g, statistic); }
+};
+
+struct CountBatch {
+  const vector<Grid> &grids;
+  unsigned threads;
+  template<class C> BatchCounts run() const { return count_batch<C>(grids, threads); }
+};
+
+struct EstimatePaths {
+  const Grid &g;
+  const Options &options;
+  template<class C> Estimate run() const {
+    const double seconds = options.limits.time_limit;
+    const size_t runs = options.runs > 0 ? options.runs : seconds > 0 ? SIZE_MAX : 32;
+    const uint64_t seed = options.seed != 0 ? options.seed : random_device{}();
+    return estimate_paths<C>(g, options.estimate, runs, seconds, options.threads, seed);
+  }
+};
+
+struct CountSharded {
+  const Grid &g;
+  const Options &options;
+  uint64_t &total;
+  template<class C> bool run() const {
+    bool ok = true;
+    repeat(options.repeat, [&]{ok = count_paths_sharded<C>(g, options.processes, total);});
+    return ok;
+  }
+};
+
+struct PathsExist {
+  const Grid &g;
+  template<class C> bool run() const { return paths_exist<C>(g); }
+};
 
-      next_neighbors.push_back(next_neighbors_col);
+template<class S>
+struct BestLayout {
+  const Grid &g;
+  const CostGrid &costs;
+  SweepControl *control;
+  template<class C> vector<segment_t> run() const {
+    vector<semiring_layer_t<S, C> > layers;
+    semiring_paths<S, C>(g, &costs, &layers, control);
+    if (control and control->stopped())
+      return vector<segment_t>();
+    return reconstruct_layout<S, C>(g, costs, layers);
   }
+};
+
+// what happened, on stderr, and the exit status for a sweep stopped early
+int stopped(const SweepControl &control, const Options &options) {
+  cerr << "Stopped at row " << control.stopped_row() + 1 << ": " << control.reason() << endl;
+  if (not options.limits.snapshot_file.empty())
+    cerr << "Resume with --resume " << options.limits.snapshot_file << endl;
+  return 3;
 }
 
+int run_semiring(const Grid &g, const Options &options) {
+  if (options.semiring == "exists") {
+    cout << (with_configuration(g.cols, PathsExist{g}) ? "yes" : "no") << endl;
+    return 0;
+  }
 
-template<class ConfigurationT>
-class for_each_next_config {
-private:
-  const Grid::Node::ordinate_t row, size;
-  const ConfigurationT &last_config;
-  const vector<vector<Grid::Node> > &next_neighbors;
-  const function<void (const ConfigurationT&)> action;
-
-  vector<Grid::Node::degree_t> residual_degrees;
-  vector<bool> vmask, hmask;
-
-public:
-
-  for_each_next_config(const int row_, 
-		       const ConfigurationT &last_config_, 
-		       const vector<Grid::Node::degree_t>& target_degrees_, 
-		       const vector<vector<Grid::Node> >& next_neighbors_,
-		       const function<void (const ConfigurationT&) > &action_)
-    : row(row_), 
-      size(last_config_.size()), 
-      last_config(last_config_), 
-      next_neighbors(next_neighbors_), 
-      action(action_),
-      residual_degrees(last_config_.size()),
-      vmask(last_config_.size(), false),
-      hmask(last_config_.size(), false)
-  {
-    for(auto col : range(size)) {
-      residual_degrees[col] = target_degrees_[col] - (last_config.col_advances(col) ? 1 : 0);
+  CostGrid costs(g.rows, g.cols);
+  if (not options.costs_file.empty()) {
+    ifstream file(options.costs_file);
+    costs = CostGrid(file, g.rows, g.cols);
+    if (not costs.valid) {
+      cerr << "'" << options.costs_file << "' is not a " << g.cols << "x" << g.rows
+	   << " cost grid" << endl;
+      return 1;
     }
-
-    enumerate_options(0);
   }
 
-  void enumerate_options(Grid::Node::ordinate_t col) {
-    assert(col < size);
+  unique_ptr<SweepControl> control(options.controlled() ? new SweepControl(options.limits, g.rows) : nullptr);
+  const vector<segment_t> layout = options.semiring == "min" ?
+    with_configuration(g.cols, BestLayout<MinCostSemiring>{g, costs, control.get()}) :
+    with_configuration(g.cols, BestLayout<MaxCostSemiring>{g, costs, control.get()});
+  if (control and control->stopped())
+    return stopped(*control, options);
+  if (layout.empty()) {
+    cout << "none" << endl;
+    return 0;
+  }
 
-    const auto r = residual_degrees[col];
-    if (r <= 0) {
-      if (col == size - 1) {
-    	yield_configuration();
-      } else {
-	hmask[col] = vmask[col] = false;
-    	enumerate_options(col + 1);
-      }
-      return;
+  cost_t total = 0;
+  for(auto row : range(g.rows)) {
+    for(auto col : range(g.cols)) {
+      if (g.nodes[g.index(row, col)].target_degree > 0)
+	total += costs.cell_cost(row, col);
     }
-      
-
-    for(auto neighbor_comb : combinations<Grid::Node>(next_neighbors[col], r)) {
-      hmask[col] = vmask[col] = false;
-			   
-      for(Grid::Node neighbor : neighbor_comb) {
-	--residual_degrees[col];
-	if (neighbor.row == row) {
-	  --residual_degrees[col + 1];
-	  hmask[col] = true;
-	} else {
-	  vmask[col] = true;
-	}
-      }
+  }
+  for(auto &segment : layout) {
+    const auto &a = segment.first;
+    total += (a.first == segment.second.first ?
+	      costs.right_cost(a.first, a.second) : costs.down_cost(a.first, a.second));
+  }
 
-      if (col == size - 1) {
-	yield_configuration();
-      } else {
-	enumerate_options(col + 1);
-      }
+  cout << total << endl;
+  for(auto &segment : layout) {
+    cout << "(" << (int)segment.first.first << "," << (int)segment.first.second << ")-("
+	 << (int)segment.second.first << "," << (int)segment.second.second << ") ";
+  }
+  cout << endl;
 
-      for(Grid::Node neighbor : neighbor_comb) {
-	++residual_degrees[col];
-	if (neighbor.row == row) {
-	  ++residual_degrees[col + 1];
-	}
-      }
+  return 0;
+}
+
+int run_zdd(const FrontierPlan &plan, const Options &options,
+	    function<void (ostream &, Graph::index_t)> print_vertex) {
+  Zdd zdd = with_configuration(plan.slots, BuildZdd{plan});
+
+  if (not options.zdd_file.empty()) {
+    ofstream out(options.zdd_file, ios::binary);
+    zdd.save(out);
+    if (not out) {
+      cerr << "Couldn't write '" << options.zdd_file << "'" << endl;
+      return 1;
     }
   }
 
-  void yield_configuration() const {
-    ConfigurationT config(last_config);
-    int start = -1;
-
-    for(auto col : range(size)) {
-      if (hmask[col] and (col == 0 or not hmask[col-1])) {
-	start = col;
-      } else if (hmask[col] == 0 and col > 0 and hmask[col-1]) {
-	if (config.link_would_close(start, col)) {
-	  return; // reject this configuration
-	}
-	config.link(start, col);
-      } else if (vmask[col]) {
-	config.link(col, col);
+  cout << zdd.count() << endl;
+
+  if (options.samples > 0 and zdd.root != Zdd::bottom) {
+    mt19937_64 rng(random_device{}());
+    for(unsigned i = 0; i < options.samples; ++i) {
+      for(auto var : zdd.sample(rng)) {
+	print_vertex(cout, zdd.edges[var].a);
+	cout << "-";
+	print_vertex(cout, zdd.edges[var].b);
+	cout << " ";
       }
+      cout << endl;
     }
+  }
 
-    config.mask(vmask);
+  return 0;
+}
+
+// the frontier count of every part decompose leaves whole
+uint64_t count_parts(const Graph &graph, const Options &options) {
+  const auto solve = [&](const Graph &part) -> uint64_t {
+    FrontierPlan plan(part, plan_order(part, options.order));
+    return with_configuration(plan.slots, CountFrontierPaths{plan, options});
+  };
+  return count_decomposed(graph, solve, options.threads);
+}
 
-    action(config);
+int run_graph(const Graph &graph, const Options &options) {
+  vertex_order_t order = plan_order(graph, options.order);
+  if (order.size() != graph.size()) {
+    cerr << "Unknown vertex order '" << options.order << "'" << endl;
+    return 2;
   }
-};
 
+  if (options.decompose and options.zdd_file.empty() and options.samples == 0) {
+    cout << count_parts(graph, options) << endl;
+    return 0;
+  }
 
+  FrontierPlan plan(graph, order);
 
-			  
-template<class ConfigurationT>
-int count_paths(Grid g) {
-  typedef unordered_map<ConfigurationT, unsigned int> config_set_t;
-  typedef typename config_set_t::value_type config_count_t;
+  if (not options.zdd_file.empty() or options.samples > 0)
+    return run_zdd(plan, options, [](ostream &os, Graph::index_t v) { os << v; });
 
-  config_set_t cur_configs, next_configs;
-  vector<Grid::Node::degree_t> target_degrees(g.cols, -1);
-  vector<vector<Grid::Node> > next_neighbors(g.cols);
+  cout << with_configuration(plan.slots, CountFrontierPaths{plan, options}) << endl;
 
-  ConfigurationT initial_config(vector<int>(g.cols, 0));
-  cur_configs.insert(make_pair(initial_config, 1));
+  return 0;
+}
 
-  for(auto row : range(g.rows)) {
-    row_setup(g, row, target_degrees, next_neighbors);
-    
-    for(auto cur_config_count : cur_configs) {
-      const ConfigurationT &cur_config = cur_config_count.first;
-      const int &cur_count = cur_config_count.second;
-      for_each_next_config<ConfigurationT>(row, cur_config, target_degrees, next_neighbors,
-        [&](const ConfigurationT &next_config) {
-          next_configs[next_config] += cur_count;
-        });
+// one line per value of the statistic: turns and layouts, or horizontal
+// and vertical segments and layouts
+int run_histogram(const Grid &g, const Options &options) {
+  const bool turns = options.histogram == "turns";
+  const size_t segments = rooms(g) - (g.have_start_and_end ? 1 : 0);
+  if (rooms(g) >= max_histogram_terms)
+    cerr << "counts past " << max_histogram_terms - 1 << " " << options.histogram << " are dropped" << endl;
+
+  const vector<uint64_t> histogram =
+    with_configuration(g.cols, CountHistogram{g, turns ? turns_statistic : horizontal_statistic});
+  for(size_t k = 0; k < histogram.size(); ++k) {
+    if (histogram[k] == 0)
+      continue;
+    cout << k << " ";
+    if (not turns)
+      cout << segments - k << " ";
+    cout << histogram[k] << endl;
+  }
+  return 0;
+}
+
+// Everything but the grid's input: its orientation, then the mode the
+// options pick, from plans and ZDDs through the semirings to the count.
+int run_grid(Grid g, const Options &options) {
+  if (options.transpose or options.flip)
+    g = g.reoriented(options.transpose, options.flip);
+
+  if (options.plan) {
+    print_plan(cout, plan_grid(g, 1000));
+    return 0;
+  }
+
+  if (not options.zdd_file.empty() or options.samples > 0)
+    return run_zdd(FrontierPlan(g), options, [&](ostream &os, Graph::index_t v) {
+	auto pos = g.coordinates(v);
+	os << "(" << (int)pos.first << "," << (int)pos.second << ")";
+      });
+
+  if (options.semiring != "count")
+    return run_semiring(g, options);
+
+  if (options.decompose)
+    return run_graph(Graph(g), options);
+
+  if (options.transfer) {
+    cout << with_configuration(g.cols, CountPowered{g, options}) << endl;
+    return 0;
+  }
+
+  if (options.symmetry) {
+    cout << with_configuration(g.cols, CountMirrored{g, options}) << endl;
+    return 0;
+  }
+
+  if (not options.histogram.empty())
+    return run_histogram(g, options);
+
+  if (options.estimate > 0) {
+    const Estimate estimate = with_configuration(g.cols, EstimatePaths{g, options});
+    cout << setprecision(6) << estimate.mean << " +- " << estimate.half_width
+	 << " (95%, " << estimate.runs << " runs)" << endl;
+    return 0;
+  }
+
+  if (options.processes > 0) {
+    if (g.cols > max_packed_cols) {
+      cerr << "--processes takes grids of at most " << max_packed_cols << " columns" << endl;
+      return 2;
     }
+    uint64_t total;
+    if (not with_configuration(g.cols, CountSharded{g, options, total}))
+      return 1;
+    cout << (int)total << endl;
+    return 0;
+  }
 
-    swap(cur_configs, next_configs);
-    next_configs.clear();
+  // auto leaves sweeps under control, sorted, cached or counted to the row sweep
+  const bool plain = (not options.controlled() and options.aggregate == "hash" and options.cache_dir.empty() and
+		      not options.counters);
+  if (options.engine == "dfs" or (options.engine == "auto" and plain and prefer_dfs(g))) {
+    if (not dfs_fits(g)) {
+      cerr << "--engine dfs takes grids of at most 128 cells with an intake and an AC" << endl;
+      return 2;
+    }
+    uint64_t total = 0;
+    repeat(options.repeat, [&]{total = count_paths_dfs(g, options.threads);});
+    cout << (int)total << endl;
+    return 0;
   }
 
-  return accumulate(begin(cur_configs), end(cur_configs), 0, 
-		    [](int sum, config_count_t config_count_t) { 
-		      return sum + config_count_t.second; 
-		    });
+  unique_ptr<SweepControl> control(options.controlled() ? new SweepControl(options.limits, g.rows) : nullptr);
+  const CountGridPaths count{g, options, control.get()};
+
+  if (not options.cache_dir.empty()) {
+    ResultCache cache(options.cache_dir);
+    const string key = "count " + canonical_form(g);
+    int64_t total;
+    if (not cache.lookup(key, total)) {
+      total = with_configuration(g.cols, count);
+      if (control and control->stopped())
+	return stopped(*control, options);
+      if (not cache.store(key, total))
+	cerr << "Couldn't write the result cache in '" << options.cache_dir << "'" << endl;
+    }
+    cout << total << endl;
+    return 0;
+  }
+
+  const int total = with_configuration(g.cols, count);
+  if (control and control->stopped())
+    return stopped(*control, options);
+  cout << total << endl;
+
+  return 0;
+}
+
+// every grid of a grid file in turn, as if each were given alone
+int run_grid_file(const Options &options) {
+  GridFile grids(options.input);
+  if (not grids.ok()) {
+    cerr << grids.error() << endl;
+    return 1;
+  }
+  Grid g(0, 0);
+  while (grids.next(g)) {
+    const int status = run_grid(g, options);
+    if (status != 0)
+      return status;
+  }
+  if (not grids.error().empty()) {
+    cerr << options.input << ": " << grids.error() << endl;
+    return 1;
+  }
+  return 0;
 }
 
+// Every grid of the input, counted a width at once with shared leading
+// rows; the counts in input order.
+int run_batch(const Options &options, istream &input) {
+  vector<Grid> grids;
+  string error;
+  if (GridFile::is_grid_file(options.input)) {
+    GridFile file(options.input);
+    Grid g(0, 0);
+    while (file.next(g)) {
+      grids.push_back(g);
+    }
+    error = file.error();
+  } else {
+    const string text((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    size_t pos = 0;
+    while (error.empty() and not at_end(text, pos)) {
+      Grid g(0, 0);
+      if (parse_grid(text, pos, g, error))
+	grids.push_back(g);
+    }
+  }
+  if (not error.empty()) {
+    cerr << (options.input.empty() ? "stdin" : options.input) << ": " << error << endl;
+    return 1;
+  }
 
+  map<size_t, vector<size_t> > by_width;
+  for(auto i : range(grids.size())) {
+    by_width[grids[i].cols].push_back(i);
+  }
+  vector<uint64_t> counts(grids.size());
+  size_t rows = 0, rows_swept = 0;
+  for(auto &width : by_width) {
+    vector<Grid> same_width;
+    for(auto i : width.second) {
+      same_width.push_back(grids[i]);
+      rows += grids[i].rows;
+    }
+    const BatchCounts batch = with_configuration(width.first, CountBatch{same_width, options.threads});
+    for(auto i : range(width.second.size())) {
+      counts[width.second[i]] = batch.counts[i];
+    }
+    rows_swept += batch.rows_swept;
+  }
 
-template<typename F>
-void repeat(size_t times, F action) {
-  for(size_t i = times; i != 0; --i) 
-    action();
+  for(auto count : counts) {
+    cout << count << endl;
+  }
+  cerr << grids.size() << " grids, " << rows_swept << " of their " << rows << " rows swept" << endl;
+  return 0;
 }
 
 int main(int argc, char *argv[]) {
-  const bool use_file = argc > 1;
-  ifstream file;  
+  Options options;
+  if (not options.parse(argc, argv))
+    return 2;
 
+  pages::backing_t backing;
+  pages::parse_backing(options.pages, backing);
+  pages::set_backing(backing);
+  unique_ptr<pages::Report> page_report(options.page_stats ? new pages::Report(cerr) : nullptr);
+  unique_ptr<counters::Report> counter_report(options.counters ? new counters::Report(cerr) : nullptr);
 
+  const bool use_file = not options.input.empty();
+  ifstream file;  
+
+  if (use_file and not options.graph and not options.batch and GridFile::is_grid_file(options.input))
+    return run_grid_file(options);
 
   if (use_file) {
-    file.open(argv[1]);
+    file.open(options.input);
     if(not file.is_open()) {
-      cerr << "Couldn't open '" << argv[1] << "'" << endl;
+      cerr << "Couldn't open '" << options.input << "'" << endl;
       return 1;
     }
   }
 
-  int count = 1;
-  if (argc > 2) {
-    count = atoi(argv[2]);
-  }
-
-  Grid g(use_file ? file.seekg(0) : cin);
+  istream &input = use_file ? file : cin;
 
-  int total = 0;
+  if (options.batch)
+    return run_batch(options, input);
 
-  
-  if (g.cols <= 8) {
-    repeat(count, [&]{total = count_paths<Max8Configuration>(g);});
-  } else {
-    repeat(count, [&]{total = count_paths<ResizableConfiguration>(g);});
+  if (options.graph) {
+    Graph graph;
+    string error;
+    if (not read_graph(input, graph, error)) {
+      cerr << (use_file ? options.input : "stdin") << ": " << error << endl;
+      return 1;
+    }
+    return run_graph(graph, options);
   }
 
-  cout << total << endl;
-
-  return 0;
+  Grid g(0, 0);
+  string error;
+  if (not read_grid(input, g, error)) {
+    cerr << (use_file ? options.input : "stdin") << ": " << error << endl;
+    return 1;
+  }
+  return run_grid(g, options);
 }
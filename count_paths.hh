@@ -0,0 +1,462 @@
+#ifndef __COUNT_PATHS_HH__
+#define __COUNT_PATHS_HH__
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+
+#include "configuration.hh"
+#include "config_types.hh"
+#include "semiring.hh"
+#include "costs.hh"
+#include "page_alloc.hh"
+#include "sweep_control.hh"
+#include "counters.hh"
+#include "grid.hh"
+#include "combinations.hh"
+#include "range.hh"
+#include "vector_out.hh"
+
+using namespace std;
+
+
+
+inline void row_setup(Grid g, Grid::Node::ordinate_t row, 
+	       vector<Grid::Node::degree_t> &target_degrees, 
+	       vector< vector<Grid::Node> > &next_neighbors) 
+{
+  target_degrees.clear();
+  next_neighbors.clear();
+
+  for(Grid::Node::ordinate_t col : range(g.cols)) {
+    target_degrees.emplace_back(g.target_degree(row, col));
+
+      vector<Grid::Node> next_neighbors_col;
+      for(Grid::Node neighbor : g.neighbors(row, col)) {
+	if (neighbor.row > row or (neighbor.row == row and neighbor.col > col)) {
+	  next_neighbors_col.push_back(neighbor);
+	}
+      }
+
+      next_neighbors.push_back(next_neighbors_col);
+  }
+}
+
+
+// Calls action with every configuration the next row can turn
+// last_config into.  The edge action also gets the row's edges: hmask[col]
+// for the segment to col+1, vmask[col] for the one down.
+template<class ConfigurationT>
+class for_each_next_config {
+public:
+  typedef function<void (const ConfigurationT&)> action_t;
+  typedef function<void (const ConfigurationT&,
+			 const vector<bool> &hmask, const vector<bool> &vmask)> edge_action_t;
+
+private:
+  const Grid::Node::ordinate_t row, size;
+  const ConfigurationT &last_config;
+  const vector<vector<Grid::Node> > &next_neighbors;
+  const action_t action;
+  const edge_action_t edge_action;
+
+  vector<Grid::Node::degree_t> residual_degrees;
+  vector<bool> vmask, hmask;
+
+public:
+
+  for_each_next_config(const int row_, 
+		       const ConfigurationT &last_config_, 
+		       const vector<Grid::Node::degree_t>& target_degrees_, 
+		       const vector<vector<Grid::Node> >& next_neighbors_,
+		       const action_t &action_)
+    : row(row_), 
+      size(last_config_.size()), 
+      last_config(last_config_), 
+      next_neighbors(next_neighbors_), 
+      action(action_),
+      residual_degrees(last_config_.size()),
+      vmask(last_config_.size(), false),
+      hmask(last_config_.size(), false)
+  {
+    start(target_degrees_);
+  }
+
+  for_each_next_config(const int row_, 
+		       const ConfigurationT &last_config_, 
+		       const vector<Grid::Node::degree_t>& target_degrees_, 
+		       const vector<vector<Grid::Node> >& next_neighbors_,
+		       const edge_action_t &edge_action_)
+    : row(row_), 
+      size(last_config_.size()), 
+      last_config(last_config_), 
+      next_neighbors(next_neighbors_), 
+      edge_action(edge_action_),
+      residual_degrees(last_config_.size()),
+      vmask(last_config_.size(), false),
+      hmask(last_config_.size(), false)
+  {
+    start(target_degrees_);
+  }
+
+  void start(const vector<Grid::Node::degree_t>& target_degrees) {
+    for(auto col : range(size)) {
+      residual_degrees[col] = target_degrees[col] - (last_config.col_advances(col) ? 1 : 0);
+    }
+
+    enumerate_options(0);
+  }
+
+  void enumerate_options(Grid::Node::ordinate_t col) {
+    assert(col < size);
+
+    const auto r = residual_degrees[col];
+    if (r <= 0) {
+      hmask[col] = vmask[col] = false;
+      if (col == size - 1) {
+    	yield_configuration();
+      } else {
+    	enumerate_options(col + 1);
+      }
+      return;
+    }
+      
+
+    for(auto neighbor_comb : combinations<Grid::Node>(next_neighbors[col], r)) {
+      hmask[col] = vmask[col] = false;
+			   
+      for(Grid::Node neighbor : neighbor_comb) {
+	--residual_degrees[col];
+	if (neighbor.row == row) {
+	  --residual_degrees[col + 1];
+	  hmask[col] = true;
+	} else {
+	  vmask[col] = true;
+	}
+      }
+
+      if (col == size - 1) {
+	yield_configuration();
+      } else {
+	enumerate_options(col + 1);
+      }
+
+      for(Grid::Node neighbor : neighbor_comb) {
+	++residual_degrees[col];
+	if (neighbor.row == row) {
+	  ++residual_degrees[col + 1];
+	}
+      }
+    }
+  }
+
+  void yield_configuration() const {
+    ConfigurationT config(last_config);
+    int start = -1;
+    uint32_t keep = 0;
+
+    for(auto col : range(size)) {
+      if (col < 32)
+	keep |= (uint32_t)vmask[col] << col;
+      if (hmask[col] and (col == 0 or not hmask[col-1])) {
+	start = col;
+      } else if (hmask[col] == 0 and col > 0 and hmask[col-1]) {
+	if (config.link_would_close(start, col)) {
+	  return; // reject this configuration
+	}
+	config.link(start, col);
+      } else if (vmask[col]) {
+	config.link(col, col);
+      }
+    }
+
+    if (size <= 32) {
+      config.mask(keep);
+    } else {
+      config.mask(vmask);
+    }
+
+    if (action)
+      action(config);
+    else
+      edge_action(config, hmask, vmask);
+  }
+};
+
+
+
+
+// The cost of one row of a layout: its rooms and its segments.
+inline cost_t row_cost(const CostGrid &costs, Grid::Node::ordinate_t row,
+		       const vector<Grid::Node::degree_t> &target_degrees,
+		       const vector<bool> &hmask, const vector<bool> &vmask)
+{
+  cost_t cost = 0;
+  for(auto col : range(costs.cols)) {
+    if (target_degrees[col] > 0)
+      cost += costs.cell_cost(row, col);
+    if (hmask[col])
+      cost += costs.right_cost(row, col);
+    if (vmask[col])
+      cost += costs.down_cost(row, col);
+  }
+  return cost;
+}
+
+template<class S, class ConfigurationT>
+using semiring_layer_t = unordered_map<ConfigurationT, semiring_value<S>,
+				       hash<ConfigurationT>, equal_to<ConfigurationT>,
+				       page_allocator<pair<const ConfigurationT, semiring_value<S> > > >;
+
+// Hands sink every successor of config in row with its value: value
+// times the weight of the row's segments.
+template<class S, class ConfigurationT, class Sink>
+inline void expand_state(Grid::Node::ordinate_t row, const ConfigurationT &config,
+			 typename S::value_type value, const CostGrid *costs,
+			 const vector<Grid::Node::degree_t> &target_degrees,
+			 const vector<vector<Grid::Node> > &next_neighbors, Sink sink)
+{
+  if (S::weighted) {
+    for_each_next_config<ConfigurationT>(row, config, target_degrees, next_neighbors,
+      [&](const ConfigurationT &next_config, const vector<bool> &hmask, const vector<bool> &vmask) {
+	const cost_t cost = row_cost(*costs, row, target_degrees, hmask, vmask);
+	sink(next_config, S::times(value, S::weight(cost)));
+      });
+  } else {
+    for_each_next_config<ConfigurationT>(row, config, target_degrees, next_neighbors,
+      [&](const ConfigurationT &next_config) { sink(next_config, value); });
+  }
+}
+
+// The row sweep over semiring S: the plus of all layouts of the times of
+// their row weights.  Weighted semirings need costs.  With layers the
+// states before every row, and after the last, are kept for
+// reconstruct_layout.  With control the sweep reports its progress, may
+// start from a snapshot and stops early, leaving a snapshot, when a limit
+// is hit; the result is then zero().  With counters on, the states are
+// expanded in batches, see counters.hh.
+template<class S, class ConfigurationT>
+typename S::value_type semiring_paths(Grid g, const CostGrid *costs = nullptr,
+				      vector<semiring_layer_t<S, ConfigurationT> > *layers = nullptr,
+				      SweepControl *control = nullptr)
+{
+  typedef typename S::value_type value_t;
+  typedef semiring_layer_t<S, ConfigurationT> config_set_t;
+
+  assert(costs or not S::weighted);
+
+  config_set_t cur_configs, next_configs;
+  vector<Grid::Node::degree_t> target_degrees(g.cols, -1);
+  vector<vector<Grid::Node> > next_neighbors(g.cols);
+
+  size_t first_row = 0;
+  if (control and not control->settings().resume_file.empty()) {
+    assert(not layers);
+    if (not snapshot::load(control->settings().resume_file, S::name(), g, first_row, cur_configs)) {
+      control->stop("unusable snapshot '" + control->settings().resume_file + "'");
+      return S::zero();
+    }
+  } else {
+    ConfigurationT initial_config(vector<int>(g.cols, 0));
+    cur_configs[initial_config].value = S::one();
+  }
+
+  for(auto row : range(first_row, g.rows)) {
+    {
+      counters::Scope scope(counters::row_setup);
+      row_setup(g, row, target_degrees, next_neighbors);
+    }
+    if (layers)
+      layers->push_back(cur_configs);
+    bool stop = control and not control->start_row(row, cur_configs.size());
+    
+    const auto merge = [&](const ConfigurationT &next_config, value_t value) {
+      value_t &next_value = next_configs[next_config].value;
+      next_value = S::plus(next_value, value);
+    };
+
+    if (counters::enabled) {
+      vector<pair<ConfigurationT, value_t> > successors;
+      for(auto it = cur_configs.begin(); it != cur_configs.end() and not stop; ) {
+	{
+	  counters::Scope scope(counters::expand);
+	  for(size_t n = 0; n < counters::batch and it != cur_configs.end(); ++n, ++it) {
+	    if (control and not control->keep_going()) {
+	      stop = true;
+	      break;
+	    }
+	    expand_state<S>(row, it->first, it->second.value, costs, target_degrees, next_neighbors,
+	      [&](const ConfigurationT &next_config, value_t value) {
+		successors.emplace_back(next_config, value);
+	      });
+	  }
+	}
+	counters::Scope scope(counters::aggregate);
+	for(auto &successor : successors) {
+	  merge(successor.first, successor.second);
+	}
+	successors.clear();
+      }
+    } else {
+      for(auto &cur_config_count : cur_configs) {
+	if (stop or (control and not control->keep_going())) {
+	  stop = true;
+	  break;
+	}
+	expand_state<S>(row, cur_config_count.first, cur_config_count.second.value, costs,
+			target_degrees, next_neighbors, merge);
+      }
+    }
+
+    if (stop) {
+      if (not control->settings().snapshot_file.empty())
+	snapshot::save(control->settings().snapshot_file, S::name(), g, row, cur_configs);
+      return S::zero();
+    }
+    if (control)
+      control->finish_row(next_configs.size());
+
+    swap(cur_configs, next_configs);
+    next_configs.clear();
+  }
+
+  if (layers)
+    layers->push_back(cur_configs);
+
+  value_t total = S::zero();
+  for(auto &config_value : cur_configs) {
+    total = S::plus(total, config_value.second.value);
+  }
+  return total;
+}
+
+template<class ConfigurationT>
+int count_paths(Grid g) {
+  return semiring_paths<CountSemiring<unsigned int>, ConfigurationT>(g);
+}
+
+// Whether the grid has any layout at all.  Rather than carrying every
+// state down the grid this goes depth first, row by row, and stops at the
+// first state that gets past the last row.  States that lead nowhere are
+// remembered per row, so none is expanded twice.
+template<class ConfigurationT>
+class paths_exist_search {
+  const size_t rows;
+  vector<vector<Grid::Node::degree_t> > target_degrees;
+  vector<vector<vector<Grid::Node> > > next_neighbors;
+  vector<unordered_set<ConfigurationT> > dead;
+  bool found;
+
+  void visit(size_t row, const ConfigurationT &config) {
+    if (row == rows) {
+      found = true;
+      return;
+    }
+    if (dead[row].count(config))
+      return;
+
+    for_each_next_config<ConfigurationT>(row, config, target_degrees[row], next_neighbors[row],
+      [&](const ConfigurationT &next_config) {
+	if (not found)
+	  visit(row + 1, next_config);
+      });
+
+    if (not found)
+      dead[row].insert(config);
+  }
+
+public:
+  paths_exist_search(Grid g) :
+    rows(g.rows),
+    target_degrees(g.rows),
+    next_neighbors(g.rows),
+    dead(g.rows),
+    found(false)
+  {
+    for(auto row : range(g.rows)) {
+      row_setup(g, row, target_degrees[row], next_neighbors[row]);
+    }
+    visit(0, ConfigurationT(vector<int>(g.cols, 0)));
+  }
+
+  operator bool() const { return found; }
+};
+
+template<class ConfigurationT>
+bool paths_exist(Grid g) {
+  return paths_exist_search<ConfigurationT>(g);
+}
+
+typedef pair<Grid::Node::coordinate_t, Grid::Node::coordinate_t> segment_t;
+
+// Walks layers, as left by semiring_paths<S>, back from the best final
+// state and returns the segments of a layout that attains the total.
+// Empty if there is no layout.
+template<class S, class ConfigurationT>
+vector<segment_t> reconstruct_layout(Grid g, const CostGrid &costs,
+				     const vector<semiring_layer_t<S, ConfigurationT> > &layers)
+{
+  typedef typename S::value_type value_t;
+
+  assert(layers.size() == g.rows + 1);
+
+  vector<segment_t> segments;
+  vector<Grid::Node::degree_t> target_degrees(g.cols, -1);
+  vector<vector<Grid::Node> > next_neighbors(g.cols);
+
+  // the final state whose value is the total
+  const ConfigurationT *cur = nullptr;
+  value_t cur_value = S::zero();
+  for(auto &config_value : layers.back()) {
+    if (not cur or S::plus(cur_value, config_value.second.value) != cur_value) {
+      cur = &config_value.first;
+      cur_value = config_value.second.value;
+    }
+  }
+  if (not cur or cur_value == S::zero())
+    return segments;
+
+  for(int row = g.rows - 1; row >= 0; --row) {
+    row_setup(g, row, target_degrees, next_neighbors);
+
+    const ConfigurationT *prev = nullptr;
+    vector<bool> prev_hmask, prev_vmask;
+    for(auto &config_value : layers[row]) {
+      const value_t prev_value = config_value.second.value;
+      for_each_next_config<ConfigurationT>(row, config_value.first, target_degrees, next_neighbors,
+        [&](const ConfigurationT &next_config, const vector<bool> &hmask, const vector<bool> &vmask) {
+	  if (prev or not (next_config == *cur))
+	    return;
+	  const cost_t cost = row_cost(costs, row, target_degrees, hmask, vmask);
+	  if (S::times(prev_value, S::weight(cost)) == cur_value) {
+	    prev = &config_value.first;
+	    prev_hmask = hmask;
+	    prev_vmask = vmask;
+	  }
+	});
+      if (prev) {
+	cur_value = prev_value;
+	break;
+      }
+    }
+    assert(prev);
+
+    const auto at = [](int row, int col) { return Grid::Node::coordinate_t(row, col); };
+    for(auto col : range(g.cols)) {
+      if (prev_hmask[col])
+	segments.push_back(segment_t(at(row, col), at(row, col + 1)));
+      if (prev_vmask[col])
+	segments.push_back(segment_t(at(row, col), at(row + 1, col)));
+    }
+    cur = prev;
+  }
+
+  sort(begin(segments), end(segments));
+  return segments;
+}
+
+
+#endif
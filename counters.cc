@@ -0,0 +1,171 @@
+#include "counters.hh"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#endif
+
+namespace counters {
+  bool enabled = false;
+
+  namespace {
+    int fds[events] = {-1, -1, -1, -1, -1};
+
+    struct Totals {
+      double seconds;
+      long long counts[events];
+      size_t scopes;
+    };
+    Totals totals[phases];
+
+    // where the open scope of each phase began
+    chrono::steady_clock::time_point began_at[phases];
+    long long began[phases][events];
+
+    // the event's count so far, scaled up if the kernel multiplexed it
+    long long read_event(int fd) {
+      unsigned long long value[3];  // value, time enabled, time running
+      if (fd < 0 or read(fd, value, sizeof(value)) != sizeof(value))
+	return 0;
+      if (value[2] == 0)
+	return 0;
+      return value[2] == value[1] ? value[0] : (long long)((double)value[0] * value[1] / value[2]);
+    }
+
+    // the event on the calling thread, and with inherit on the threads it
+    // starts from now on
+    int open_event(event_t event, bool inherit) {
+#ifdef __linux__
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      switch(event) {
+      case cycles: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+      case instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+      case cache_misses: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+      case branch_misses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+      default:
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.config = (PERF_COUNT_HW_CACHE_DTLB |
+		       (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+      }
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.inherit = inherit;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+      (void)event;
+      (void)inherit;
+      return -1;
+#endif
+    }
+  }
+
+  const char *phase_name(phase_t phase) {
+    switch(phase) {
+    case row_setup: return "row setup";
+    case expand: return "expand";
+    case aggregate: return "aggregate";
+    default: return "?";
+    }
+  }
+
+  const char *event_name(event_t event) {
+    switch(event) {
+    case cycles: return "cycles";
+    case instructions: return "instructions";
+    case cache_misses: return "cache-misses";
+    case branch_misses: return "branch-misses";
+    case dtlb_misses: return "dTLB-misses";
+    default: return "?";
+    }
+  }
+
+  bool start() {
+    for(int e = 0; e < events; ++e) {
+      if (fds[e] < 0)
+	fds[e] = open_event(event_t(e), false);
+    }
+    reset();
+    enabled = true;
+    for(int e = 0; e < events; ++e) {
+      if (fds[e] >= 0)
+	return true;
+    }
+    return false;
+  }
+
+  void reset() {
+    memset(totals, 0, sizeof(totals));
+  }
+
+  Total::Total(event_t event) : fd(open_event(event, true)) {}
+
+  Total::~Total() {
+    if (fd >= 0)
+      close(fd);
+  }
+
+  long long Total::count() const {
+    return read_event(fd);
+  }
+
+  void begin(phase_t phase) {
+    for(int e = 0; e < events; ++e) {
+      began[phase][e] = read_event(fds[e]);
+    }
+    began_at[phase] = chrono::steady_clock::now();
+  }
+
+  void end(phase_t phase) {
+    Totals &t = totals[phase];
+    t.seconds += chrono::duration<double>(chrono::steady_clock::now() - began_at[phase]).count();
+    for(int e = 0; e < events; ++e) {
+      t.counts[e] += read_event(fds[e]) - began[phase][e];
+    }
+    ++t.scopes;
+  }
+
+  void report(ostream &os) {
+    const ios::fmtflags flags = os.flags();
+    os << "counters: " << left << setw(11) << "phase" << right << setw(10) << "seconds";
+    for(int e = 0; e < events; ++e) {
+      os << setw(15) << event_name(event_t(e));
+    }
+    os << setw(7) << "IPC" << endl;
+
+    for(int p = 0; p < phases; ++p) {
+      const Totals &t = totals[p];
+      os << "counters: " << left << setw(11) << phase_name(phase_t(p)) << right
+	 << setw(10) << fixed << setprecision(4) << t.seconds;
+      for(int e = 0; e < events; ++e) {
+	if (fds[e] >= 0)
+	  os << setw(15) << t.counts[e];
+	else
+	  os << setw(15) << "-";
+      }
+      if (fds[cycles] >= 0 and fds[instructions] >= 0 and t.counts[cycles] > 0)
+	os << setw(7) << setprecision(2) << (double)t.counts[instructions] / t.counts[cycles];
+      else
+	os << setw(7) << "-";
+      os << endl;
+    }
+
+    string unavailable;
+    for(int e = 0; e < events; ++e) {
+      if (fds[e] < 0)
+	unavailable += string(unavailable.empty() ? "" : ", ") + event_name(event_t(e));
+    }
+    if (not unavailable.empty())
+      os << "counters: " << unavailable << " unavailable, the kernel would not open them" << endl;
+    os.flags(flags);
+  }
+}
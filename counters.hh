@@ -0,0 +1,75 @@
+#ifndef __COUNTERS_HH__
+#define __COUNTERS_HH__
+
+#include <cstddef>
+#include <iostream>
+using namespace std;
+
+// Hardware counters per phase of the row sweep: cycles, instructions,
+// cache misses, branch mispredicts and dTLB load misses from
+// perf_event_open, and wall time.
+// A Scope adds what the counters moved while it was open to its phase.
+//
+// Off by default: a Scope is then one test of enabled, and the sweep
+// keeps its usual loop.  Turned on, the sweep expands a batch of states
+// into a buffer before merging it, so that expansion and aggregation
+// land in their own scopes; see semiring_paths.  Counters the kernel will
+// not open (containers often forbid them all) are reported unavailable
+// and the phases are still timed.  Only the calling thread is counted.
+namespace counters {
+  enum phase_t { row_setup, expand, aggregate, phases };
+  enum event_t { cycles, instructions, cache_misses, branch_misses, dtlb_misses, events };
+
+  const char *phase_name(phase_t phase);
+  const char *event_name(event_t event);
+
+  // states expanded before their successors are merged
+  const size_t batch = 4096;
+
+  extern bool enabled;
+
+  // opens the counters and turns the scopes on; false if none would open
+  bool start();
+  // zeroes the phases' totals
+  void reset();
+  void report(ostream &os);
+
+  // Starts the counters on construction and reports them when destroyed.
+  class Report {
+    ostream &os;
+  public:
+    Report(ostream &os) : os(os) { start(); }
+    ~Report() { report(os); }
+  };
+
+  // One event counted from construction on, for reports that are not
+  // split by phase.  Unlike the phases it takes in the threads started
+  // meanwhile, once they are joined.
+  class Total {
+    int fd;
+  public:
+    Total(event_t event);
+    ~Total();
+    bool available() const { return fd >= 0; }
+    long long count() const;
+  };
+
+  void begin(phase_t phase);
+  void end(phase_t phase);
+
+  class Scope {
+    const phase_t phase;
+  public:
+    Scope(phase_t phase) : phase(phase) {
+      if (enabled)
+	begin(phase);
+    }
+    ~Scope() {
+      if (enabled)
+	end(phase);
+    }
+  };
+}
+
+
+#endif
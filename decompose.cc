@@ -0,0 +1,330 @@
+#include "decompose.hh"
+
+#include <algorithm>
+#include <thread>
+#include "range.hh"
+
+vector<Graph::index_t> articulation_points(const Graph &g, const vector<bool> &removed) {
+  typedef Graph::index_t index_t;
+  const index_t none = (index_t)-1;
+
+  // Tarjan's low points, with an explicit stack: corridors make the depth
+  // first search as deep as the graph is large.
+  vector<index_t> discovered(g.size(), none), low(g.size(), 0), parent(g.size(), none);
+  vector<size_t> next_edge(g.size(), 0);
+  vector<bool> is_cut(g.size(), false);
+  vector<index_t> stack;
+  index_t time = 0;
+
+  for(index_t root = 0; root < g.size(); ++root) {
+    if (removed[root] or discovered[root] != none)
+      continue;
+    size_t root_children = 0;
+    discovered[root] = low[root] = time++;
+    stack.push_back(root);
+
+    while (not stack.empty()) {
+      const index_t v = stack.back();
+      if (next_edge[v] < g.adjacency[v].size()) {
+	const index_t w = g.adjacency[v][next_edge[v]++];
+	if (removed[w])
+	  continue;
+	if (discovered[w] == none) {
+	  parent[w] = v;
+	  discovered[w] = low[w] = time++;
+	  stack.push_back(w);
+	  if (v == root)
+	    ++root_children;
+	} else if (w != parent[v]) {
+	  low[v] = min(low[v], discovered[w]);
+	}
+	continue;
+      }
+
+      stack.pop_back();
+      const index_t p = parent[v];
+      if (p != none) {
+	low[p] = min(low[p], low[v]);
+	if (p != root and low[v] >= discovered[p])
+	  is_cut[p] = true;
+      }
+    }
+    if (root_children > 1)
+      is_cut[root] = true;
+  }
+
+  vector<index_t> cuts;
+  for(auto v : range(g.size())) {
+    if (is_cut[v])
+      cuts.push_back(v);
+  }
+  return cuts;
+}
+
+Graph induced_subgraph(const Graph &g, const vector<Graph::index_t> &vertices,
+		       Graph::index_t start, Graph::index_t end) {
+  typedef Graph::index_t index_t;
+  const index_t none = (index_t)-1;
+
+  vector<index_t> renumbered(g.size(), none);
+  for(auto i : range(vertices.size())) {
+    renumbered[vertices[i]] = i;
+  }
+
+  Graph sub;
+  sub.target_degrees.assign(vertices.size(), 2);
+  sub.adjacency.resize(vertices.size());
+  for(auto i : range(vertices.size())) {
+    for(auto w : g.adjacency[vertices[i]]) {
+      if (renumbered[w] != none)
+	sub.adjacency[i].push_back(renumbered[w]);
+    }
+  }
+  sub.start_idx = start;
+  sub.end_idx = end;
+  sub.have_start_and_end = true;
+  sub.target_degrees[start] = sub.target_degrees[end] = 1;
+  return sub;
+}
+
+namespace {
+  typedef Graph::index_t index_t;
+  typedef function<uint64_t (const Graph &)> solver_t;
+
+  // below this many vertices splitting costs more than it saves
+  const size_t min_split_size = 8;
+  // The rest of a separator split is counted twice, with and without the
+  // virtual edge, so a wing smaller than this (a corner cell, say) would
+  // double the work for nothing.
+  const size_t min_wing_size = 8;
+  // the separator pairs search is quadratic; above this, leave it to solve
+  const size_t max_separator_search = 4096;
+
+  struct Decomposer {
+    const solver_t &solve;
+    DecomposeStats &stats;
+
+    // the components of g without the removed vertices
+    vector<vector<index_t> > components(const Graph &g, const vector<bool> &removed) const {
+      vector<vector<index_t> > found;
+      vector<bool> seen(removed);
+      for(auto root : range(g.size())) {
+	if (seen[root])
+	  continue;
+	found.push_back(vector<index_t>{(index_t)root});
+	seen[root] = true;
+	vector<index_t> &component = found.back();
+	for(size_t i = 0; i < component.size(); ++i) {
+	  for(auto w : g.adjacency[component[i]]) {
+	    if (not seen[w]) {
+	      seen[w] = true;
+	      component.push_back(w);
+	    }
+	  }
+	}
+      }
+      return found;
+    }
+
+    bool has_endpoint(const Graph &g, const vector<index_t> &component) const {
+      for(auto v : component) {
+	if (v == g.start_idx or v == g.end_idx)
+	  return true;
+      }
+      return false;
+    }
+
+    // where v is in vertices, or its size
+    static index_t position(const vector<index_t> &vertices, index_t v) {
+      return find(vertices.begin(), vertices.end(), v) - vertices.begin();
+    }
+
+    bool is_endpoint(const Graph &g, index_t v) const {
+      return v == g.start_idx or v == g.end_idx;
+    }
+
+    uint64_t reject() const {
+      stats.rejected = true;
+      return 0;
+    }
+
+    // a and b, the second on another thread if there is one to spare
+    template<class A, class B>
+    pair<uint64_t, uint64_t> both(unsigned threads, A a, B b) const {
+      if (threads < 2)
+	return make_pair(a(threads), b(threads));
+      uint64_t first = 0;
+      thread worker([&]{ first = a(threads / 2); });
+      const uint64_t second = b(threads - threads / 2);
+      worker.join();
+      return make_pair(first, second);
+    }
+
+    uint64_t count(const Graph &input, unsigned threads) const {
+      if (not input.have_start_and_end) {
+	++stats.leaves;
+	return solve(input);
+      }
+
+      // drop the excluded vertices, so every vertex left must be covered
+      vector<index_t> kept;
+      index_t start = 0, end = 0;
+      for(index_t v = 0; v < input.size(); ++v) {
+	if (v == input.start_idx)
+	  start = kept.size();
+	if (v == input.end_idx)
+	  end = kept.size();
+	if (input.target_degrees[v] > 0)
+	  kept.push_back(v);
+      }
+      const Graph g = induced_subgraph(input, kept, start, end);
+
+      for(auto v : range(g.size())) {
+	if (g.adjacency[v].size() < (size_t)g.target_degrees[v])
+	  return reject();
+      }
+      const vector<bool> none_removed(g.size(), false);
+      if (components(g, none_removed).size() > 1)
+	return reject();
+
+      if (g.size() < min_split_size) {
+	++stats.leaves;
+	return solve(g);
+      }
+
+      // A cut vertex splits the path in two, s to v on one side and v to t
+      // on the other; an endpoint as cut vertex, or a side without an
+      // endpoint, leaves no path.
+      index_t best_cut = 0;
+      size_t best_balance = 0;
+      vector<index_t> best_start_side, best_end_side;
+      for(auto v : articulation_points(g, none_removed)) {
+	if (is_endpoint(g, v))
+	  return reject();
+	vector<bool> removed(g.size(), false);
+	removed[v] = true;
+	auto sides = components(g, removed);
+	if (sides.size() != 2 or not has_endpoint(g, sides[0]) or not has_endpoint(g, sides[1]))
+	  return reject();
+	const size_t balance = min(sides[0].size(), sides[1].size());
+	if (balance > best_balance) {
+	  best_balance = balance;
+	  best_cut = v;
+	  const bool first_has_start = position(sides[0], g.start_idx) < sides[0].size();
+	  best_start_side = sides[first_has_start ? 0 : 1];
+	  best_end_side = sides[first_has_start ? 1 : 0];
+	}
+      }
+      if (best_balance > 0) {
+	++stats.cuts;
+	best_start_side.push_back(best_cut);
+	best_end_side.push_back(best_cut);
+	const Graph start_side = induced_subgraph(g, best_start_side, position(best_start_side, g.start_idx),
+						  best_start_side.size() - 1);
+	const Graph end_side = induced_subgraph(g, best_end_side, best_end_side.size() - 1,
+						position(best_end_side, g.end_idx));
+	const auto counts = both(threads,
+	  [&](unsigned t) { return count(start_side, t); },
+	  [&](unsigned t) { return count(end_side, t); });
+	return counts.first * counts.second;
+      }
+
+      if (g.size() > max_separator_search) {
+	++stats.leaves;
+	return solve(g);
+      }
+
+      // A wing cut off by {u, w} without an endpoint in it is entered at
+      // one and left at the other, exactly once: two passes would close a
+      // loop through u and w.  Two such wings cannot both be covered.
+      index_t best_u = 0, best_w = 0;
+      vector<index_t> best_wing;
+      best_balance = 0;
+      for(index_t u = 0; u < g.size(); ++u) {
+	if (is_endpoint(g, u))
+	  continue;
+	vector<bool> removed(g.size(), false);
+	removed[u] = true;
+	for(auto w : articulation_points(g, removed)) {
+	  if (w < u or is_endpoint(g, w))
+	    continue;
+	  removed[w] = true;
+	  vector<index_t> wing;
+	  size_t wings = 0;
+	  for(auto &component : components(g, removed)) {
+	    if (not has_endpoint(g, component)) {
+	      ++wings;
+	      wing = component;
+	    }
+	  }
+	  removed[w] = false;
+	  if (wings > 1)
+	    return reject();
+	  const size_t balance = min(wing.size(), g.size() - wing.size() - 2);
+	  if (wings == 1 and balance >= min_wing_size and balance > best_balance) {
+	    best_balance = balance;
+	    best_u = u;
+	    best_w = w;
+	    swap(best_wing, wing);
+	  }
+	}
+      }
+      if (best_balance == 0) {
+	++stats.leaves;
+	return solve(g);
+      }
+
+      // the wing from u to w, and the rest with u-w as a virtual edge that
+      // must be used: paths with the edge less paths without it
+      ++stats.separators;
+      vector<bool> in_wing(g.size(), false);
+      for(auto v : best_wing) {
+	in_wing[v] = true;
+      }
+      vector<index_t> rest;
+      index_t rest_start = 0, rest_end = 0;
+      for(index_t v = 0; v < g.size(); ++v) {
+	if (in_wing[v])
+	  continue;
+	if (v == g.start_idx)
+	  rest_start = rest.size();
+	if (v == g.end_idx)
+	  rest_end = rest.size();
+	rest.push_back(v);
+      }
+      best_wing.insert(begin(best_wing), best_u);
+      best_wing.push_back(best_w);
+
+      Graph wing = induced_subgraph(g, best_wing, 0, best_wing.size() - 1);
+      remove_edge(wing, 0, best_wing.size() - 1);
+      Graph without = induced_subgraph(g, rest, rest_start, rest_end);
+      const index_t u = position(rest, best_u), w = position(rest, best_w);
+      remove_edge(without, u, w);
+      Graph with(without);
+      with.adjacency[u].push_back(w);
+      with.adjacency[w].push_back(u);
+
+      const auto counts = both(threads,
+	[&](unsigned t) { return count(wing, t); },
+	[&](unsigned t) {
+	  const auto rest_counts = both(t,
+	    [&](unsigned t) { return count(with, t); },
+	    [&](unsigned t) { return count(without, t); });
+	  return rest_counts.first - rest_counts.second;
+	});
+      return counts.first * counts.second;
+    }
+
+    static void remove_edge(Graph &g, index_t u, index_t w) {
+      auto &from_u = g.adjacency[u], &from_w = g.adjacency[w];
+      from_u.erase(remove(begin(from_u), end(from_u), w), end(from_u));
+      from_w.erase(remove(begin(from_w), end(from_w), u), end(from_w));
+    }
+  };
+}
+
+uint64_t count_decomposed(const Graph &g, const function<uint64_t (const Graph &)> &solve,
+			  unsigned threads, DecomposeStats *stats) {
+  DecomposeStats local;
+  return Decomposer{solve, stats ? *stats : local}.count(g, max(threads, 1u));
+}
@@ -0,0 +1,39 @@
+#ifndef __DECOMPOSE_HH__
+#define __DECOMPOSE_HH__
+
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <stdint.h>
+#include "graph.hh"
+using namespace std;
+
+// Splits the path count of a graph where it is narrow.  A path through
+// every room crosses an articulation point once, so the two sides are
+// counted separately, each with the cut as an endpoint, and multiplied;
+// any other shape of cut has no path at all.  A wing hanging off a
+// separator {u, w} without an endpoint in it is entered through one and
+// left through the other, so it is counted as paths from u to w, and the
+// rest of the graph as paths that use a virtual edge u-w in its place.
+// The sides are counted recursively, and in parallel while threads last;
+// what no longer splits goes to solve.
+struct DecomposeStats {
+  atomic<size_t> cuts, separators, leaves;
+  atomic<bool> rejected;  // the shape alone showed there is no path
+
+  DecomposeStats() : cuts(0), separators(0), leaves(0), rejected(false) {}
+};
+
+uint64_t count_decomposed(const Graph &g, const function<uint64_t (const Graph &)> &solve,
+			  unsigned threads, DecomposeStats *stats = nullptr);
+
+// the articulation points of g without the removed vertices
+vector<Graph::index_t> articulation_points(const Graph &g, const vector<bool> &removed);
+
+// g on the vertices listed, renumbered in that order, between start and
+// end (indices into vertices)
+Graph induced_subgraph(const Graph &g, const vector<Graph::index_t> &vertices,
+		       Graph::index_t start, Graph::index_t end);
+
+
+#endif
@@ -0,0 +1,67 @@
+#include "decompose.hh"
+#include "frontier.hh"
+#include "ordering.hh"
+#include "count_paths.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <random>
+#include <sstream>
+#include <string>
+using namespace std;
+
+uint64_t count_whole(const Graph &graph) {
+  return count_frontier_paths<VectorConfig>(FrontierPlan(graph, plan_order(graph, "auto")));
+}
+
+TEST(Decompose, splits_agree_with_whole_count) {
+  // random plans: obstacles make cut cells, corridors and dead wings
+  mt19937 rng(7);
+  DecomposeStats stats;
+  for(int trial = 0; trial < 300; ++trial) {
+    const int cols = 5 + rng() % 5, rows = 4 + rng() % 4;
+    vector<int> cells(cols * rows, 0);
+    for(auto &cell : cells) {
+      cell = rng() % 5 == 0 ? 1 : 0;
+    }
+    const int start = rng() % cells.size();
+    int end = rng() % cells.size();
+    while (end == start)
+      end = rng() % cells.size();
+    cells[start] = 2;
+    cells[end] = 3;
+
+    ostringstream text;
+    text << cols << " " << rows;
+    for(auto cell : cells) {
+      text << " " << cell;
+    }
+    Grid grid = parse(text.str());
+    const uint64_t expected = count_paths<VectorConfig>(grid);
+    EXPECT_EQ(expected, count_decomposed(Graph(grid), count_whole, trial % 3 + 1, &stats)) << text.str();
+  }
+  EXPECT_LT(0u, stats.cuts.load());
+  EXPECT_TRUE(stats.rejected);
+}
+
+TEST(Decompose, corridor_and_wing) {
+  // two rooms joined by the one cell corridor at (1,4)
+  Grid rooms = parse("9 4  2 0 0 0 1 0 0 0 0  0 0 0 0 0 0 0 0 0"
+		     "  0 0 0 0 1 0 0 0 0  0 0 0 0 1 0 0 0 3");
+  DecomposeStats stats;
+  EXPECT_EQ((uint64_t)count_paths<VectorConfig>(rooms), count_decomposed(Graph(rooms), count_whole, 2, &stats));
+  EXPECT_LT(0u, stats.cuts.load());
+
+  // the right room is a wing behind the two cell door in column 5
+  Grid door = parse("10 4  2 0 0 0 0 1 0 0 0 0  0 0 0 0 0 0 0 0 0 0"
+		    "  0 0 0 0 0 0 0 0 0 0  3 0 0 0 0 1 0 0 0 0");
+  DecomposeStats separated;
+  EXPECT_EQ(60u, count_decomposed(Graph(door), count_whole, 4, &separated));
+  EXPECT_EQ(1u, separated.separators.load());
+
+  // a pocket below the corridor would have to be entered twice
+  Grid pocket = parse("5 3  2 0 0 0 3  0 1 0 1 0  0 1 0 1 0");
+  DecomposeStats rejected;
+  EXPECT_EQ(0u, count_decomposed(Graph(pocket), count_whole, 1, &rejected));
+  EXPECT_TRUE(rejected.rejected);
+}
@@ -0,0 +1,41 @@
+#ifndef __DFS_HH__
+#define __DFS_HH__
+
+#include <string>
+#include <stdint.h>
+#include "grid.hh"
+using namespace std;
+
+// The other engine: depth first path extension over occupancy bitboards,
+// for grids with few free rooms, where the frontier sweep carries more
+// states than there are paths to walk.  The grid must fit 128 cells and
+// have an intake and an AC.
+//
+// Every extension is pruned when
+//   - a room left behind has fewer than two ways in and out (one for the AC),
+//   - the rooms not yet visited are no longer connected to the head,
+//   - the checkerboard colours of the rooms left cannot alternate to the AC.
+// Subtrees near the root go to per-thread deques; idle threads steal the
+// oldest, that is the largest, subtree of another.
+
+bool dfs_fits(const Grid &g);
+
+// Picks the engine from the grid's statistics: the free rooms, which
+// bound the depth first search, against the widest frontier the sweep
+// would carry.
+bool prefer_dfs(const Grid &g);
+
+uint64_t count_paths_dfs(const Grid &g, unsigned threads);
+
+// The size of the search, without doing it, by Knuth's random probes:
+// each probe walks one random branch down, and the product of the
+// branchings it passes stands for the nodes at every depth.  The time is
+// the probes' time per node, on one thread.
+struct DfsEstimate {
+  double nodes, seconds;
+};
+
+DfsEstimate estimate_dfs(const Grid &g, size_t probes, unsigned seed);
+
+
+#endif
@@ -0,0 +1,87 @@
+#include "dfs.hh"
+#include "count_paths.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <random>
+#include <sstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+// The rooms of a random self avoiding walk, and extra random rooms, with
+// the intake and the AC at the walk's ends: at least one path.
+Grid walk_grid(mt19937 &rng, int cols, int rows, int extra) {
+  vector<int> cells(cols * rows, 1), walk(1, rng() % (cols * rows));
+  cells[walk[0]] = 0;
+  for(;;) {
+    const int cell = walk.back(), row = cell / cols, col = cell % cols;
+    vector<int> next;
+    if (col > 0 and cells[cell - 1])
+      next.push_back(cell - 1);
+    if (col + 1 < cols and cells[cell + 1])
+      next.push_back(cell + 1);
+    if (row > 0 and cells[cell - cols])
+      next.push_back(cell - cols);
+    if (row + 1 < rows and cells[cell + cols])
+      next.push_back(cell + cols);
+    if (next.empty())
+      break;
+    walk.push_back(next[rng() % next.size()]);
+    cells[walk.back()] = 0;
+  }
+  for(int i = 0; i < extra; ++i) {
+    cells[rng() % cells.size()] = 0;
+  }
+  cells[walk.front()] = 2;
+  cells[walk.back()] = 3;
+
+  ostringstream text;
+  text << cols << " " << rows;
+  for(auto cell : cells) {
+    text << " " << cell;
+  }
+  return parse(text.str());
+}
+
+TEST(Dfs, agrees_with_the_sweep) {
+  Grid hard = parse(hard_grid);
+  EXPECT_EQ(301716u, count_paths_dfs(hard, 1));
+  EXPECT_EQ(301716u, count_paths_dfs(hard, 4));
+  EXPECT_EQ(2u, count_paths_dfs(parse("4 3  2 0 0 0  0 0 0 0  0 0 3 1"), 1));
+  EXPECT_EQ(0u, count_paths_dfs(parse("4 4  2 0 0 0  0 0 0 0  0 0 0 0  0 0 0 3"), 2));
+
+  mt19937 rng(40);
+  for(int i = 0; i < 200; ++i) {
+    const int cols = 2 + rng() % 11, rows = 2 + rng() % (80 / cols - 1);
+    const Grid g = walk_grid(rng, cols, rows, rng() % 4);
+    ASSERT_TRUE(dfs_fits(g));
+    const uint64_t expected = semiring_paths<CountSemiring<uint64_t>, VectorConfig>(g);
+    EXPECT_EQ(expected, count_paths_dfs(g, 1)) << cols << "x" << rows;
+    EXPECT_EQ(expected, count_paths_dfs(g, 3)) << cols << "x" << rows;
+  }
+}
+
+// cols x rows with rooms in the first room_cols columns of the first
+// room_rows rows, the intake and the AC at the corners of those
+Grid room_grid(int cols, int rows, int room_cols, int room_rows) {
+  ostringstream text;
+  text << cols << " " << rows;
+  for(int row = 0; row < rows; ++row) {
+    for(int col = 0; col < cols; ++col) {
+      const bool inside = row < room_rows and col < room_cols;
+      const bool last = row == room_rows - 1 and col == room_cols - 1;
+      text << " " << (not inside ? 1 : row == 0 and col == 0 ? 2 : last ? 3 : 0);
+    }
+  }
+  return parse(text.str());
+}
+
+TEST(Dfs, prefers_sparse_grids) {
+  EXPECT_FALSE(prefer_dfs(room_grid(11, 11, 11, 11)));
+  EXPECT_FALSE(dfs_fits(room_grid(12, 11, 4, 4)));
+
+  const Grid corner = room_grid(12, 10, 5, 4);
+  EXPECT_TRUE(prefer_dfs(corner));
+  EXPECT_EQ((semiring_paths<CountSemiring<uint64_t>, VectorConfig>(corner)), count_paths_dfs(corner, 2));
+}
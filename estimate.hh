@@ -0,0 +1,145 @@
+#ifndef __ESTIMATE_HH__
+#define __ESTIMATE_HH__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#include "count_paths.hh"
+using namespace std;
+
+// Layout counts of grids too big to sweep exactly.  A sampled sweep keeps
+// at most max_states states a row, chosen by priority sampling: a state of
+// weight w gets the priority w/u, u uniform in (0,1], the max_states of
+// highest priority stay and each weighs max(w, t) from then on, t the
+// highest priority dropped.  That keeps every sum over the states unbiased,
+// so the run's total is an unbiased estimate of the count; rows that fit
+// are swept exactly.  Independent runs on every thread give a mean and a
+// 95% confidence interval, Student's t over the runs' spread.
+struct Estimate {
+  double mean;
+  double half_width;  // the interval is mean +- half_width
+  size_t runs;
+};
+
+template<class ConfigurationT>
+double sampled_sweep(const Grid &g, size_t max_states, mt19937_64 &rng) {
+  typedef unordered_map<ConfigurationT, double, hash<ConfigurationT>, equal_to<ConfigurationT>,
+			page_allocator<pair<const ConfigurationT, double> > > layer_t;
+
+  vector<Grid::Node::degree_t> target_degrees(g.cols, -1);
+  vector<vector<Grid::Node> > next_neighbors(g.cols);
+  layer_t cur_configs, next_configs;
+  cur_configs[ConfigurationT(vector<int>(g.cols, 0))] = 1;
+
+  uniform_real_distribution<double> uniform;
+  vector<pair<double, typename layer_t::const_iterator> > priorities;
+  for(auto row : range(g.rows)) {
+    row_setup(g, row, target_degrees, next_neighbors);
+    for(auto &config_weight : cur_configs) {
+      const double weight = config_weight.second;
+      for_each_next_config<ConfigurationT>(row, config_weight.first, target_degrees, next_neighbors,
+        [&](const ConfigurationT &next_config) { next_configs[next_config] += weight; });
+    }
+    cur_configs.clear();
+
+    if (next_configs.size() > max_states) {
+      priorities.clear();
+      for(auto it = next_configs.cbegin(); it != next_configs.cend(); ++it) {
+	priorities.emplace_back(it->second / (1 - uniform(rng)), it);
+      }
+      const auto by_priority = [](const pair<double, typename layer_t::const_iterator> &a,
+				  const pair<double, typename layer_t::const_iterator> &b) {
+	return a.first > b.first;
+      };
+      nth_element(priorities.begin(), priorities.begin() + max_states, priorities.end(), by_priority);
+      const double threshold = priorities[max_states].first;
+      for(size_t i = 0; i < max_states; ++i) {
+	cur_configs[priorities[i].second->first] = max(priorities[i].second->second, threshold);
+      }
+      next_configs.clear();
+    } else {
+      swap(cur_configs, next_configs);
+    }
+  }
+
+  double total = 0;
+  for(auto &config_weight : cur_configs) {
+    total += config_weight.second;
+  }
+  return total;
+}
+
+// the 97.5th percentile of Student's t with degrees of freedom
+inline double t_quantile(size_t degrees) {
+  static const double table[] = {
+    0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  if (degrees < sizeof(table) / sizeof(table[0]))
+    return table[degrees];
+  return degrees < 60 ? 2.000 : degrees < 120 ? 1.980 : 1.960;
+}
+
+// Sampled sweeps of g until max_runs are done or, with seconds, until the
+// time is up; at least two either way.  Run i draws from seed and i alone,
+// so the runs and their estimate do not depend on the threads.
+template<class ConfigurationT>
+Estimate estimate_paths(const Grid &g, size_t max_states, size_t max_runs, double seconds,
+			unsigned threads, uint64_t seed)
+{
+  typedef chrono::steady_clock clock;
+  const clock::time_point deadline =
+    clock::now() + chrono::duration_cast<clock::duration>(chrono::duration<double>(seconds));
+  max_runs = max<size_t>(max_runs, 2);
+
+  atomic<size_t> next_run(0);
+  mutex m;
+  vector<pair<size_t, double> > totals;
+  const auto work = [&]() {
+    for(;;) {
+      const size_t run = next_run++;
+      if (run >= max_runs or (run >= 2 and seconds > 0 and clock::now() > deadline))
+	return;
+      seed_seq seeds{seed, (uint64_t)run};
+      mt19937_64 rng(seeds);
+      const double total = sampled_sweep<ConfigurationT>(g, max_states, rng);
+      lock_guard<mutex> lock(m);
+      totals.emplace_back(run, total);
+    }
+  };
+
+  vector<thread> workers;
+  for(unsigned i = 1; i < threads; ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for(auto &worker : workers) {
+    worker.join();
+  }
+
+  // summed in run order, so that the rounding is the same every time
+  sort(totals.begin(), totals.end());
+  const size_t n = totals.size();
+  double sum = 0;
+  for(auto &run_total : totals) {
+    sum += run_total.second;
+  }
+  const double mean = sum / n;
+  double squares = 0;
+  for(auto &run_total : totals) {
+    squares += (run_total.second - mean) * (run_total.second - mean);
+  }
+  return Estimate{mean, t_quantile(n - 1) * sqrt(squares / (n - 1) / n), n};
+}
+
+
+#endif
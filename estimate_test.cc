@@ -0,0 +1,40 @@
+#include "estimate.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <vector>
+#include <string>
+using namespace std;
+
+TEST(Estimate, exact_when_the_states_fit) {
+  const Estimate estimate = estimate_paths<VectorConfig>(parse(hard_grid), 1000, 4, 0, 1, 1);
+  EXPECT_EQ(301716, estimate.mean);
+  EXPECT_EQ(0, estimate.half_width);
+  EXPECT_EQ(4u, estimate.runs);
+}
+
+// One 95% interval in twenty misses; twice as wide they all should.
+TEST(Estimate, intervals_cover_the_count) {
+  for(auto &g : {parse(hard_grid), open_grid(7, 7)}) {
+    const double exact = semiring_paths<CountSemiring<uint64_t>, VectorConfig>(g);
+    for(uint64_t seed : {1, 2, 3}) {
+      const Estimate estimate = estimate_paths<VectorConfig>(g, 40, 200, 0, 1, seed);
+      EXPECT_LT(0, estimate.half_width);
+      EXPECT_GT(2 * estimate.half_width, fabs(estimate.mean - exact)) << estimate.mean << " " << exact;
+    }
+  }
+}
+
+TEST(Estimate, runs_do_not_depend_on_threads) {
+  const Grid g = open_grid(6, 6);
+  const Estimate one = estimate_paths<VectorConfig>(g, 30, 20, 0, 1, 46);
+  const Estimate three = estimate_paths<VectorConfig>(g, 30, 20, 0, 3, 46);
+  EXPECT_EQ(one.mean, three.mean);
+  EXPECT_EQ(one.half_width, three.half_width);
+}
+
+TEST(Estimate, stops_at_the_time_limit) {
+  const Estimate estimate = estimate_paths<VectorConfig>(open_grid(9, 9), 100, SIZE_MAX, 0.2, 2, 5);
+  EXPECT_LE(2u, estimate.runs);
+  EXPECT_LT(0, estimate.mean);
+}
@@ -0,0 +1,77 @@
+#include "frontier.hh"
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include <limits>
+
+FrontierPlan::FrontierPlan(const Grid &g) : slots(0) {
+  vector<Graph::index_t> order(g.nodes.size());
+  iota(begin(order), end(order), 0);
+  build(Graph(g), order);
+}
+
+FrontierPlan::FrontierPlan(const Graph &g,
+			   const vector<Graph::index_t> &order) : slots(0) {
+  build(g, order);
+}
+
+void FrontierPlan::build(const Graph &g,
+			 const vector<Graph::index_t> &order) {
+  assert(order.size() == g.size());
+
+  const size_t unvisited = numeric_limits<size_t>::max();
+  vector<size_t> position(g.size(), unvisited);
+  for(auto i : range(order.size())) {
+    position[order[i]] = i;
+  }
+
+  // slot of the dangling edge between a visited vertex and each neighbour
+  vector< vector<slot_t> > slot_to(g.size());
+  set<slot_t> free_slots;
+  slot_t next_slot = 0;
+
+  edges.clear();
+  steps.clear();
+
+  for(auto v : order) {
+    Step step;
+    step.vertex = v;
+    step.target_degree = g.target_degrees[v];
+
+    for(auto slot : slot_to[v]) {
+      step.in_slots.push_back(slot);
+      free_slots.insert(slot);
+    }
+    slot_to[v].clear();
+
+    vector<Graph::index_t> later;
+    for(auto w : g.adjacency[v]) {
+      if (position[w] > position[v])
+	later.push_back(w);
+    }
+    sort(begin(later), end(later), [&](Graph::index_t a, Graph::index_t b) {
+	return position[a] < position[b];
+      });
+    assert(later.size() <= max_graph_degree);
+
+    for(auto w : later) {
+      slot_t slot;
+      if (free_slots.empty()) {
+	slot = next_slot++;
+      } else {
+	slot = *begin(free_slots);
+	free_slots.erase(begin(free_slots));
+      }
+
+      step.out_edges.push_back(edges.size());
+      step.out_slots.push_back(slot);
+      edges.push_back(Edge({v, w}));
+      slot_to[w].push_back(slot);
+    }
+
+    steps.push_back(step);
+  }
+
+  slots = next_slot;
+}
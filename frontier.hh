@@ -0,0 +1,171 @@
+#ifndef __FRONTIER_HH__
+#define __FRONTIER_HH__
+
+#include <vector>
+#include <unordered_map>
+#include <numeric>
+#include <cassert>
+#include <stdint.h>
+#include "grid.hh"
+#include "graph.hh"
+#include "range.hh"
+#include "page_alloc.hh"
+using namespace std;
+
+// A frontier plan linearizes a graph for vertex-at-a-time sweeps.  Vertices
+// are visited in a fixed order; an edge "dangles" from the moment its
+// earlier end is visited until its later end is.  Every dangling edge is
+// parked in a slot, and a Configuration over the slots carries the same
+// partner semantics the row sweep uses for columns: no_partner means the
+// edge is unused, a slot naming itself leads to an endpoint, and otherwise
+// the two slots are the ends of one path fragment.
+struct FrontierPlan {
+  typedef uint16_t slot_t;
+  typedef uint32_t edge_t;
+
+  struct Edge {
+    Grid::Node::index_t a, b; // a is visited before b
+  };
+
+  struct Step {
+    Grid::Node::index_t vertex;
+    Grid::Node::degree_t target_degree;
+    vector<slot_t> in_slots;  // edges from earlier vertices
+    vector<edge_t> out_edges; // edges to later vertices, consecutive ids
+    vector<slot_t> out_slots; // parallel to out_edges
+  };
+
+  vector<Edge> edges; // edge ids double as ZDD variables
+  vector<Step> steps;
+  size_t slots;
+
+  // row-major order; slots then behave like the row sweep's columns
+  FrontierPlan(const Grid &g);
+  FrontierPlan(const Graph &g, const vector<Graph::index_t> &order);
+
+private:
+  void build(const Graph &g, const vector<Graph::index_t> &order);
+};
+
+
+template<class ConfigurationT>
+inline bool frontier_empty(const ConfigurationT &config) {
+  for(auto slot : range(config.size())) {
+    if (config.col_advances(slot))
+      return false;
+  }
+  return true;
+}
+
+template<class ConfigurationT>
+inline int frontier_in_degree(const ConfigurationT &config,
+			      const FrontierPlan::Step &step) {
+  int in = 0;
+  for(auto slot : step.in_slots) {
+    in += config.col_advances(slot) ? 1 : 0;
+  }
+  return in;
+}
+
+// Visits step.vertex, using the out edges whose bits are set in chosen.
+// Returns false if the vertex ends up with the wrong degree or the choice
+// closes a cycle; config is unspecified in that case.
+template<class ConfigurationT>
+bool frontier_step(ConfigurationT &config, const FrontierPlan::Step &step,
+		   uint32_t chosen) {
+  typedef FrontierPlan::slot_t slot_t;
+  slot_t in[2], out[2];
+  int n_in = 0, n_out = 0;
+
+  for(auto slot : step.in_slots) {
+    if (config.col_advances(slot)) {
+      if (n_in == 2)
+	return false;
+      in[n_in++] = slot;
+    }
+  }
+
+  for(size_t i = 0; i < step.out_slots.size(); ++i) {
+    if (chosen & (1u << i)) {
+      if (n_out == 2)
+	return false;
+      out[n_out++] = step.out_slots[i];
+    }
+  }
+
+  if (n_in + n_out != step.target_degree)
+    return false;
+
+  const auto link = [&](slot_t a, slot_t b) {
+    config.link(min(a, b), max(a, b));
+  };
+
+  if (n_in == 2) {
+    if (config.link_would_close(min(in[0], in[1]), max(in[0], in[1])))
+      return false;
+    link(in[0], in[1]);
+  } else if (n_in == 1 and n_out == 1) {
+    link(in[0], out[0]);
+  } else if (n_out == 2) {
+    link(out[0], out[1]);
+  } else if (n_in == 1) {
+    config.drop(in[0]);
+  } else if (n_out == 1) {
+    link(out[0], out[0]);
+  }
+
+  return true;
+}
+
+// Calls action with every set of out edges (as a bitmask) that gives
+// step.vertex its target degree on top of in already used edges.
+template<class F>
+void for_each_out_choice(const FrontierPlan::Step &step, int in, F action) {
+  const int need = step.target_degree - in;
+  const uint32_t k = step.out_edges.size();
+  if (need == 0) {
+    action(0u);
+  } else if (need == 1) {
+    for(uint32_t i = 0; i < k; ++i)
+      action(1u << i);
+  } else if (need == 2) {
+    for(uint32_t i = 0; i < k; ++i)
+      for(uint32_t j = i + 1; j < k; ++j)
+	action((1u << i) | (1u << j));
+  }
+}
+
+// The row sweep of count_paths generalized to any graph and vertex order.
+template<class ConfigurationT>
+uint64_t count_frontier_paths(const FrontierPlan &plan) {
+  typedef unordered_map<ConfigurationT, uint64_t, hash<ConfigurationT>, equal_to<ConfigurationT>,
+			page_allocator<pair<const ConfigurationT, uint64_t> > > config_set_t;
+
+  config_set_t cur_configs, next_configs;
+  cur_configs.insert(make_pair(ConfigurationT(vector<int>(plan.slots, 0)), 1));
+
+  for(auto &step : plan.steps) {
+    for(auto &cur_config_count : cur_configs) {
+      const ConfigurationT &cur_config = cur_config_count.first;
+      const uint64_t cur_count = cur_config_count.second;
+      for_each_out_choice(step, frontier_in_degree(cur_config, step), [&](uint32_t chosen) {
+	  ConfigurationT next_config(cur_config);
+	  if (frontier_step(next_config, step, chosen))
+	    next_configs[next_config] += cur_count;
+	});
+    }
+
+    swap(cur_configs, next_configs);
+    next_configs.clear();
+  }
+
+  uint64_t total = 0;
+  for(auto &config_count : cur_configs) {
+    if (frontier_empty(config_count.first))
+      total += config_count.second;
+  }
+  return total;
+}
+
+
+#endif
@@ -0,0 +1,106 @@
+#include "frontier.hh"
+#include "ordering.hh"
+#include "count_paths.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <sstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+const vector<string> grids {
+  "4 3  2 0 0 0  0 0 0 0  0 0 3 1",
+  "5 4  2 0 0 0 0  0 0 0 0 0  0 0 0 0 0  3 0 0 0 0",
+  "5 5  2 0 0 0 0  0 1 0 0 0  0 0 0 1 0  0 0 0 0 0  1 0 0 0 3",
+  "6 5  0 0 0 0 0 0  0 2 0 0 0 0  0 0 1 1 0 0  0 0 0 0 3 0  0 0 0 0 0 0",
+  "7 3  2 0 0 0 0 0 0  0 0 0 0 0 0 0  0 0 0 0 0 0 3",
+};
+
+TEST(Frontier, every_order_matches_sweep) {
+  for(auto text : grids) {
+    Grid grid = parse(text);
+    Graph graph(grid);
+    const uint64_t expected = count_paths<VectorConfig>(grid);
+
+    for(string method : {"natural", "cm", "rcm", "greedy", "auto"}) {
+      vertex_order_t order = plan_order(graph, method);
+      ASSERT_EQ(graph.size(), order.size()) << method;
+      FrontierPlan plan(graph, order);
+      EXPECT_EQ(frontier_width(graph, order), plan.slots) << method;
+      EXPECT_EQ(expected, count_frontier_paths<VectorConfig>(plan)) << text << " " << method;
+    }
+  }
+}
+
+TEST(Frontier, auto_order_is_narrowest) {
+  for(auto text : grids) {
+    Graph graph(parse(text));
+    size_t best = frontier_width(graph, plan_order(graph, "auto"));
+    for(string method : {"natural", "cm", "rcm", "greedy"}) {
+      EXPECT_LE(best, frontier_width(graph, plan_order(graph, method)));
+    }
+  }
+}
+
+TEST(Frontier, edge_list_input) {
+  // two 2x2 floors joined by a riser between vertices 1 and 4
+  istringstream is("8 9  2 0 0 0  0 3 0 0"
+		   "  0 1  0 2  1 3  2 3  4 5  4 6  5 7  6 7  1 4");
+  Graph graph(is);
+  EXPECT_EQ(9u, graph.num_edges());
+  EXPECT_TRUE(graph.have_start_and_end);
+
+  FrontierPlan plan(graph, plan_order(graph, "auto"));
+  // 0-2-3-1, up the riser, 4-6-7-5
+  EXPECT_EQ(1u, count_frontier_paths<VectorConfig>(plan));
+}
+
+TEST(Frontier, edge_list_errors) {
+  const auto problem = [](const string &text) {
+    istringstream is(text);
+    Graph graph;
+    string error;
+    EXPECT_FALSE(read_graph(is, graph, error)) << text;
+    return error;
+  };
+  EXPECT_EQ("line 1: the code of vertex 2 is more than 3", problem("3 1  2 0 7  0 1"));
+  EXPECT_EQ("line 2: edge 1 joins vertex 1 to itself", problem("3 1  2 0 3\n1 1"));
+  EXPECT_EQ("line 1: the second vertex of edge 2 is more than 2", problem("3 2  2 0 3  0 1  1 3"));
+  EXPECT_EQ("line 1: an intake without an AC", problem("3 0  2 0 0"));
+  EXPECT_EQ("line 1: a second AC", problem("3 0  3 2 3"));
+  EXPECT_EQ("line 1: the text ends before the second vertex of edge 1", problem("2 1  2 3  0"));
+  EXPECT_EQ("line 2: more after the graph", problem("2 1  2 3  0 1\n5"));
+
+  // a hub joined to every vertex of a path from the intake to the AC, one
+  // edge a line; the layouts leave the path once through the hub
+  const auto fan = [](int path) {
+    ostringstream text;
+    text << path + 1 << " " << 2 * path - 1 << "\n0 2";
+    for(int i = 2; i < path; ++i) {
+      text << " 0";
+    }
+    text << " 3\n";
+    for(int i = 1; i < path; ++i) {
+      text << i << " " << i + 1 << "\n";
+    }
+    for(int i = 1; i <= path; ++i) {
+      text << "0 " << i << "\n";
+    }
+    return text.str();
+  };
+  EXPECT_EQ("line 67: edge 65 gives vertex 0 more than 32 neighbours", problem(fan(33)));
+  istringstream fan32(fan(32));
+  Graph hub;
+  string fan_error;
+  EXPECT_TRUE(read_graph(fan32, hub, fan_error)) << fan_error;
+  for(auto order : {"natural", "greedy", "auto"}) {
+    EXPECT_EQ(31u, count_frontier_paths<VectorConfig>(FrontierPlan(hub, plan_order(hub, order)))) << order;
+  }
+
+  istringstream is("2 2  2 3  0 1  1 0");
+  Graph graph;
+  string error;
+  EXPECT_TRUE(read_graph(is, graph, error));
+  EXPECT_EQ(1u, graph.num_edges());
+}
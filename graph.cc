@@ -0,0 +1,135 @@
+#include "graph.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <iterator>
+#include <limits>
+#include "range.hh"
+
+Graph::Graph(const Grid &g) :
+  adjacency(g.adjacency),
+  start_idx(g.start_idx),
+  end_idx(g.end_idx),
+  have_start_and_end(g.have_start_and_end)
+{
+  for(auto &node : g.nodes) {
+    target_degrees.push_back(node.target_degree);
+  }
+}
+
+Graph::Graph(istream &is) {
+  string error;
+  const bool ok = read_graph(is, *this, error);
+  assert(ok);
+  (void)ok;
+}
+
+bool read_graph(istream &is, Graph &g, string &error) {
+  const string text((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+  size_t pos = 0;
+
+  const auto line = [&](size_t at) {
+    return to_string(1 + count(text.begin(), text.begin() + min(at, text.size()), '\n'));
+  };
+  const auto fail = [&](const string &problem) {
+    error = "line " + line(pos) + ": " + problem;
+    return false;
+  };
+
+  // the next number, which must be at most limit
+  const auto number = [&](const string &what, unsigned long long limit, unsigned long long &value) {
+    const size_t last = pos;
+    while (pos < text.size() and isspace((unsigned char)text[pos]))
+      ++pos;
+    if (pos == text.size()) {
+      pos = last;
+      return fail("the text ends before the " + what);
+    }
+    value = 0;
+    const size_t first = pos;
+    while (pos < text.size() and text[pos] >= '0' and text[pos] <= '9') {
+      value = min(value * 10 + (text[pos] - '0'), limit + 1);
+      ++pos;
+    }
+    if (pos == first or (pos < text.size() and not isspace((unsigned char)text[pos])))
+      return fail("the " + what + " is not a number");
+    if (value > limit)
+      return fail("the " + what + " is more than " + to_string(limit));
+    return true;
+  };
+
+  unsigned long long n, m;
+  if (not number("vertex count", numeric_limits<Graph::index_t>::max(), n) or
+      not number("edge count", numeric_limits<uint32_t>::max(), m))
+    return false;
+
+  Graph parsed;
+  parsed.target_degrees.assign(n, 2);
+  parsed.adjacency.resize(n);
+  bool have_start = false, have_end = false;
+  vector<bool> excluded(n, false);
+  for(size_t idx = 0; idx < n; ++idx) {
+    unsigned long long code;
+    if (not number("code of vertex " + to_string(idx), 3, code))
+      return false;
+    if ((code == 2 and have_start) or (code == 3 and have_end))
+      return fail(string("a second ") + (code == 2 ? "intake" : "AC"));
+    if (code == 1) {
+      parsed.target_degrees[idx] = 0;
+      excluded[idx] = true;
+    } else if (code == 2) {
+      have_start = true;
+      parsed.target_degrees[idx] = 1;
+      parsed.start_idx = idx;
+    } else if (code == 3) {
+      have_end = true;
+      parsed.target_degrees[idx] = 1;
+      parsed.end_idx = idx;
+    }
+  }
+  if (have_start != have_end)
+    return fail(have_start ? "an intake without an AC" : "an AC without an intake");
+  parsed.have_start_and_end = have_start;
+
+  for(size_t i = 0; i < m; ++i) {
+    unsigned long long u, v;
+    const string what = "edge " + to_string(i + 1);
+    if (n == 0)
+      return fail(what + " in a graph without vertices");
+    if (not number("first vertex of " + what, n - 1, u) or not number("second vertex of " + what, n - 1, v))
+      return false;
+    if (u == v)
+      return fail(what + " joins vertex " + to_string(u) + " to itself");
+    if (excluded[u] or excluded[v])
+      continue;
+    auto &neighbors = parsed.adjacency[u];
+    if (find(neighbors.begin(), neighbors.end(), v) != neighbors.end())
+      continue;
+    for(auto w : {u, v}) {
+      if (parsed.adjacency[w].size() == max_graph_degree)
+	return fail(what + " gives vertex " + to_string(w) + " more than " + to_string(max_graph_degree) +
+		    " neighbours");
+    }
+    parsed.adjacency[u].push_back(v);
+    parsed.adjacency[v].push_back(u);
+  }
+
+  const size_t more = find_if(text.begin() + pos, text.end(),
+			      [](char c) { return not isspace((unsigned char)c); }) - text.begin();
+  if (more != text.size()) {
+    error = "line " + line(more) + ": more after the graph";
+    return false;
+  }
+
+  swap(g, parsed);
+  return true;
+}
+
+size_t Graph::num_edges() const {
+  size_t twice = 0;
+  for(auto &neighbors : adjacency) {
+    twice += neighbors.size();
+  }
+  return twice / 2;
+}
@@ -0,0 +1,48 @@
+#ifndef __GRAPH_HH__
+#define __GRAPH_HH__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "grid.hh"
+using namespace std;
+
+// An arbitrary room adjacency graph, for plans that are not a single
+// rectangular lattice (several floors joined by risers, irregular rooms).
+// Vertices carry the same codes as the cells of a .quora grid.
+//
+// Input format, whitespace separated:
+//   N M
+//   code_0 ... code_{N-1}     0 room, 1 not ours, 2 intake, 3 AC
+//   u_1 v_1 ... u_M v_M       undirected edges between vertex ids
+// Repeated edges count once.  A vertex has at most max_graph_degree
+// neighbours, as the frontier chooses among a vertex's edges by 32 bit masks.
+const size_t max_graph_degree = 32;
+
+struct Graph {
+  typedef Grid::Node::index_t index_t;
+  typedef Grid::Node::degree_t degree_t;
+
+  vector<degree_t> target_degrees;
+  vector< vector<index_t> > adjacency;
+  index_t start_idx, end_idx;
+  bool have_start_and_end;
+
+  Graph() : start_idx(0), end_idx(0), have_start_and_end(false) {}
+  Graph(const Grid &g);
+  Graph(istream &is);  // asserts the input is well formed, see read_graph
+
+  inline size_t size() const { return target_degrees.size(); }
+  size_t num_edges() const;
+};
+
+// The one graph of is, checked rather than asserted: false, with the line
+// and the problem in error, on codes other than 0 to 3, a second intake or
+// AC, only one of the two, an edge to a vertex that is not there or to
+// itself, a vertex with more than max_graph_degree neighbours, text that
+// ends early or more after the graph.
+bool read_graph(istream &is, Graph &g, string &error);
+
+
+#endif
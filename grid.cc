@@ -5,6 +5,12 @@
 #include <cassert>
 #include "range.hh"
 
+namespace {
+  bool is_space(char c) {
+    return c == ' ' or c == '\t' or c == '\n' or c == '\r' or c == '\v' or c == '\f';
+  }
+}
+
 namespace std {
   template<>
   void swap(Grid &a, Grid &b) {
@@ -61,46 +67,26 @@ Grid::Grid(size_t rows, size_t cols) :
 }
 
 
-Grid::Grid(istream &is) {
-  size_t rows, cols;
-  unsigned int code;
-  bool have_start(false), have_end(false);
-
-  is >> cols;
-  is >> rows;
-  Grid g(rows, cols);
-
-  for (auto row : range(rows)) {
-    for (auto col: range(cols)) {
-      is >> code;
-      switch(code) {
-      case 0:
-	assert(g.target_degree(row, col) == 2);
-	break;
-      case 1:
-	g.target_degree(row, col) = 0;
-	g.delete_node(g.index(row, col));
-	break;
-      case 2:
-	have_start = true;
-	g.target_degree(row, col) = 1;
-	g.start_idx = g.index(row, col);
-	break;
-      case 3:
-	have_end = true;
-	g.target_degree(row, col) = 1;
-	g.end_idx = g.index(row, col);
-	break;
-      default:
-	assert(false);
-      }
-    }
+void Grid::set_code(Node::ordinate_t row, Node::ordinate_t col, unsigned code) {
+  switch(code) {
+  case 0:
+    assert(target_degree(row, col) == 2);
+    break;
+  case 1:
+    target_degree(row, col) = 0;
+    delete_node(index(row, col));
+    break;
+  case 2:
+    target_degree(row, col) = 1;
+    start_idx = index(row, col);
+    break;
+  case 3:
+    target_degree(row, col) = 1;
+    end_idx = index(row, col);
+    break;
+  default:
+    assert(false);
   }
-
-  assert(have_start == have_end);
-  g.have_start_and_end = have_start && have_end;
-
-  swap(g, *this);
 }
 
 
@@ -159,6 +145,33 @@ void Grid::print() const {
   
 }
 
+string Grid::codes() const {
+  string out(nodes.size(), '0');
+  for(Node::index_t idx = 0; idx < nodes.size(); ++idx) {
+    out[idx] = (nodes[idx].target_degree <= 0 ? '1' :
+		have_start_and_end and idx == start_idx ? '2' :
+		have_start_and_end and idx == end_idx ? '3' : '0');
+  }
+  return out;
+}
+
+Grid Grid::reoriented(bool transpose, bool flip) const {
+  const string cells = codes();
+  const size_t out_rows = transpose ? cols : rows, out_cols = transpose ? rows : cols;
+
+  Grid g(out_rows, out_cols);
+  for(size_t row = 0; row < out_rows; ++row) {
+    for(size_t col = 0; col < out_cols; ++col) {
+      size_t r = flip ? out_rows - 1 - row : row, c = col;
+      if (transpose)
+	swap(r, c);
+      g.set_code(row, col, cells[r * cols + c] - '0');
+    }
+  }
+  g.have_start_and_end = have_start_and_end;
+  return g;
+}
+
 void Grid::delete_node(Node::index_t idx) {
   for (auto other_idx : adjacency[idx]) {
     auto &other_children = adjacency[other_idx];
@@ -208,3 +221,78 @@ bool Grid::connected(Grid::Node::coordinate_t a, Grid::Node::coordinate_t b) con
   auto it = find(begin(neighbors), end(neighbors), index(b));
   return it != end(neighbors);
 }
+
+bool parse_grid(const string &text, size_t &pos, Grid &g, string &error) {
+  const auto fail = [&](const string &problem) {
+    error = "line " + to_string(1 + count(text.begin(), text.begin() + min(pos, text.size()), '\n')) +
+      ": " + problem;
+    return false;
+  };
+
+  // the next number, which must be at most limit
+  const auto number = [&](const string &what, unsigned long limit, unsigned long &value) {
+    const size_t last = pos;
+    while (pos < text.size() and is_space(text[pos]))
+      ++pos;
+    if (pos == text.size()) {
+      pos = last;
+      return fail("the text ends before the " + what);
+    }
+    value = 0;
+    const size_t first = pos;
+    while (pos < text.size() and text[pos] >= '0' and text[pos] <= '9') {
+      value = min(value * 10 + (text[pos] - '0'), limit + 1);
+      ++pos;
+    }
+    if (pos == first or (pos < text.size() and not is_space(text[pos])))
+      return fail("the " + what + " is not a number");
+    if (value > limit)
+      return fail("the " + what + " is more than " + to_string(limit));
+    return true;
+  };
+
+  unsigned long cols, rows;
+  if (not number("width", 255, cols) or not number("height", 255, rows))
+    return false;
+  if (cols == 0 or rows == 0)
+    return fail("the grid is empty");
+
+  Grid parsed(rows, cols);
+  bool have_start = false, have_end = false;
+  for(size_t row = 0; row < rows; ++row) {
+    for(size_t col = 0; col < cols; ++col) {
+      unsigned long code;
+      if (not number("code of cell (" + to_string(row) + "," + to_string(col) + ")", 3, code))
+	return false;
+      if ((code == 2 and have_start) or (code == 3 and have_end))
+	return fail(string("a second ") + (code == 2 ? "intake" : "AC"));
+      have_start |= code == 2;
+      have_end |= code == 3;
+      parsed.set_code(row, col, code);
+    }
+  }
+  if (have_start != have_end)
+    return fail(have_start ? "an intake without an AC" : "an AC without an intake");
+  parsed.have_start_and_end = have_start;
+
+  swap(g, parsed);
+  return true;
+}
+
+bool at_end(const string &text, size_t pos) {
+  return all_of(text.begin() + min(pos, text.size()), text.end(), is_space);
+}
+
+bool read_grid(istream &is, Grid &g, string &error) {
+  const string text((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+  size_t pos = 0;
+  if (not parse_grid(text, pos, g, error))
+    return false;
+  if (not at_end(text, pos)) {
+    const size_t more = find_if_not(text.begin() + pos, text.end(), is_space) - text.begin();
+    error = "line " + to_string(1 + count(text.begin(), text.begin() + more, '\n')) +
+      ": more after the grid";
+    return false;
+  }
+  return true;
+}
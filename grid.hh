@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
 #include <vector>
 #include <utility>
 #include <stdint.h>
@@ -11,7 +12,7 @@ using namespace std;
 struct Grid {
   struct Node {
     typedef uint8_t ordinate_t;
-    typedef uint8_t index_t;
+    typedef uint32_t index_t;
     typedef int8_t degree_t; // may become negative
     typedef pair<ordinate_t, ordinate_t> coordinate_t;
 
@@ -46,10 +47,13 @@ struct Grid {
 
 
   Grid(size_t rows, size_t cols);
-  Grid(istream &is);
 
   void delete_node(Node::index_t idx);
 
+  // Sets a cell of a fresh grid from its code in grid files: 0 a room, 1
+  // blocked, 2 the intake, 3 the AC.  have_start_and_end is the caller's.
+  void set_code(Node::ordinate_t row, Node::ordinate_t col, unsigned code);
+
   Node::degree_t &target_degree(Node::coordinate_t pos);
   Node::degree_t &target_degree(Node::ordinate_t row, Node::ordinate_t col);
 
@@ -60,6 +64,13 @@ struct Grid {
 
   void print() const;
 
+  // the cell codes of the grid file, '0' to '3', row by row
+  string codes() const;
+
+  // The same grid swept another way: transposed swaps rows and columns,
+  // flipped then reverses the rows.  The number of paths is the same.
+  Grid reoriented(bool transpose, bool flip) const;
+
 
   inline bool valid_coord(const Node::coordinate_t &pos) const {
     return (rows > pos.first and cols > pos.second);
@@ -86,6 +97,18 @@ struct Grid {
 
 };
 
+// Grid text as in the .quora files, W and H then W*H codes, checked
+// rather than asserted.  parse_grid reads one grid from text at pos and
+// moves pos past it; false, with the line and the problem in error, on
+// sizes outside 1 to 255, codes other than 0 to 3, a second intake or AC,
+// only one of the two, or text that ends early.
+bool parse_grid(const string &text, size_t &pos, Grid &g, string &error);
+
+// the one grid of is, with nothing but whitespace after it
+bool read_grid(istream &is, Grid &g, string &error);
+
+// whether text has only whitespace from pos on
+bool at_end(const string &text, size_t pos);
 
 
 #endif
@@ -0,0 +1,87 @@
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "grid_file.hh"
+
+using namespace std;
+
+// Converts grids between text, as in the .quora files, and grid files:
+//   grid_convert OUT IN...   every text grid in the IN files, back to back
+//                            in each, into the grid file OUT; - is stdin
+//   grid_convert --text IN   the grids of the grid file IN as text
+
+void usage(ostream &os) {
+  os << "usage: grid_convert OUT IN...  text grids to the grid file OUT (IN - is stdin)" << endl
+     << "       grid_convert --text IN   the grids of the grid file IN as text" << endl;
+}
+
+int to_text(const string &path) {
+  GridFile grids(path);
+  if (not grids.ok()) {
+    cerr << grids.error() << endl;
+    return 1;
+  }
+  Grid g(0, 0);
+  while (grids.next(g)) {
+    const string codes = g.codes();
+    cout << g.cols << " " << g.rows << endl;
+    for(size_t row = 0; row < g.rows; ++row) {
+      for(size_t col = 0; col < g.cols; ++col) {
+	cout << (col ? " " : "") << codes[row * g.cols + col];
+      }
+      cout << endl;
+    }
+  }
+  if (not grids.error().empty()) {
+    cerr << path << ": " << grids.error() << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc == 3 and string(argv[1]) == "--text")
+    return to_text(argv[2]);
+  if (argc < 3 or argv[1][0] == '-') {
+    usage(cerr);
+    return 2;
+  }
+
+  ofstream out(argv[1], ios::binary);
+  out << grid_file_header();
+  size_t written = 0;
+  for(int i = 2; i < argc; ++i) {
+    const string path = argv[i];
+    ifstream file;
+    if (path != "-") {
+      file.open(path);
+      if (not file.is_open()) {
+	cerr << "Couldn't open '" << path << "'" << endl;
+	return 1;
+      }
+    }
+    istream &input = path == "-" ? cin : file;
+    const string text((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    while (not at_end(text, pos)) {
+      Grid g(0, 0);
+      string error;
+      if (not parse_grid(text, pos, g, error)) {
+	cerr << path << ": " << error << endl;
+	return 1;
+      }
+      out << grid_record(g);
+      ++written;
+    }
+  }
+
+  if (not out) {
+    cerr << "Couldn't write '" << argv[1] << "'" << endl;
+    return 1;
+  }
+  cerr << written << " grids" << endl;
+  return 0;
+}
@@ -0,0 +1,148 @@
+#include "grid_file.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  const char magic[4] = {'Q', 'G', 'R', 'D'};
+  const uint32_t format_version = 1;
+
+  struct Header {
+    char magic[4];
+    uint32_t version;
+  };
+
+  uint32_t checksum(GridRecord record, const uint8_t *codes, size_t bytes) {
+    record.checksum = 0;
+    uint32_t h = 0x811c9dc5;
+    const uint8_t *fields = (const uint8_t *)&record;
+    for(size_t i = 0; i < sizeof(record); ++i) {
+      h = (h ^ fields[i]) * 0x01000193;
+    }
+    for(size_t i = 0; i < bytes; ++i) {
+      h = (h ^ codes[i]) * 0x01000193;
+    }
+    return h;
+  }
+
+  size_t code_bytes(size_t cells) {
+    return (cells + 3) / 4;
+  }
+}
+
+string grid_file_header() {
+  Header header;
+  memcpy(header.magic, magic, sizeof(magic));
+  header.version = format_version;
+  return string((const char *)&header, sizeof(header));
+}
+
+string grid_record(const Grid &g) {
+  const string codes = g.codes();
+  string packed(code_bytes(codes.size()), '\0');
+  for(size_t cell = 0; cell < codes.size(); ++cell) {
+    packed[cell / 4] |= (codes[cell] - '0') << (2 * (cell % 4));
+  }
+
+  GridRecord record = GridRecord();
+  record.cols = g.cols;
+  record.rows = g.rows;
+  record.start = g.have_start_and_end ? g.start_idx : GridRecord::no_cell;
+  record.end = g.have_start_and_end ? g.end_idx : GridRecord::no_cell;
+  record.checksum = checksum(record, (const uint8_t *)packed.data(), packed.size());
+  return string((const char *)&record, sizeof(record)) + packed;
+}
+
+GridFile::GridFile(const string &path) :
+  fd(open(path.c_str(), O_RDONLY)),
+  length(0),
+  offset(sizeof(Header)),
+  base(nullptr)
+{
+  struct stat st;
+  if (fd < 0 or fstat(fd, &st) != 0) {
+    problem = "couldn't open '" + path + "'";
+    return;
+  }
+  if ((size_t)st.st_size < sizeof(Header)) {
+    problem = "'" + path + "' is not a grid file";
+    return;
+  }
+  length = st.st_size;
+  void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (p == MAP_FAILED) {
+    problem = "couldn't map '" + path + "'";
+    return;
+  }
+  madvise(p, length, MADV_SEQUENTIAL);
+  base = (const uint8_t *)p;
+
+  Header header;
+  memcpy(&header, base, sizeof(header));
+  if (memcmp(header.magic, magic, sizeof(magic)) != 0 or header.version != format_version) {
+    problem = "'" + path + "' is not a grid file";
+    munmap((void *)base, length);
+    base = nullptr;
+  }
+}
+
+GridFile::~GridFile() {
+  if (base)
+    munmap((void *)base, length);
+  if (fd >= 0)
+    close(fd);
+}
+
+bool GridFile::next(Grid &g) {
+  if (not ok() or offset == length)
+    return false;
+
+  const auto fail = [&](const string &what) {
+    problem = "the record at byte " + to_string(offset) + " " + what;
+    return false;
+  };
+
+  GridRecord record;
+  if (length - offset < sizeof(record))
+    return fail("is cut short");
+  memcpy(&record, base + offset, sizeof(record));
+  const size_t cells = record.cols * record.rows, bytes = code_bytes(cells);
+  if (cells == 0)
+    return fail("has no cells");
+  if (length - offset - sizeof(record) < bytes)
+    return fail("is cut short");
+  const uint8_t *codes = base + offset + sizeof(record);
+  if (checksum(record, codes, bytes) != record.checksum or record.reserved != 0)
+    return fail("fails its checksum");
+
+  Grid read(record.rows, record.cols);
+  size_t starts = 0, ends = 0;
+  for(size_t cell = 0; cell < cells; ++cell) {
+    const unsigned code = codes[cell / 4] >> (2 * (cell % 4)) & 3;
+    if ((code == 2 and cell != record.start) or (code == 3 and cell != record.end))
+      return fail("has its intake or AC out of place");
+    starts += code == 2;
+    ends += code == 3;
+    read.set_code(cell / record.cols, cell % record.cols, code);
+  }
+  if (starts != (record.start != GridRecord::no_cell) or ends != (record.end != GridRecord::no_cell) or
+      starts != ends)
+    return fail("has its intake or AC out of place");
+  read.have_start_and_end = starts == 1;
+
+  offset += sizeof(record) + bytes;
+  swap(g, read);
+  return true;
+}
+
+bool GridFile::is_grid_file(const string &path) {
+  ifstream file(path, ios::binary);
+  char start[sizeof(magic)];
+  return file.read(start, sizeof(start)) and memcmp(start, magic, sizeof(magic)) == 0;
+}
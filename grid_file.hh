@@ -0,0 +1,53 @@
+#ifndef __GRID_FILE_HH__
+#define __GRID_FILE_HH__
+
+#include <iostream>
+#include <string>
+#include <stdint.h>
+#include "grid.hh"
+using namespace std;
+
+// Grid files hold any number of grids back to back after a short header.
+// Every grid is a 12 byte record header, its width, height, intake and AC
+// cells and a checksum, followed by its codes at 2 bits a cell, four
+// cells a byte, low bits first.  Numbers are in host byte order.
+struct GridRecord {
+  uint8_t cols, rows;
+  uint16_t start, end;  // cell indices, or no_cell
+  uint16_t reserved;    // zero
+  uint32_t checksum;    // FNV-1a of the fields above and the codes
+
+  static const uint16_t no_cell = 0xffff;
+};
+
+// the file header grid files start with
+string grid_file_header();
+
+// the record of g, header and codes
+string grid_record(const Grid &g);
+
+// The grids of a grid file, read in place from a read only mapping.
+class GridFile {
+  int fd;
+  size_t length, offset;
+  const uint8_t *base;
+  string problem;
+
+public:
+  GridFile(const string &path);
+  ~GridFile();
+
+  // false, see error(), if the file could not be mapped or has no header
+  bool ok() const { return base != nullptr; }
+  const string &error() const { return problem; }
+
+  // The next grid in g; false at the end of the file, or with error() set
+  // on a record that is cut short, inconsistent or fails its checksum.
+  bool next(Grid &g);
+
+  // whether the file at path starts with the grid file header
+  static bool is_grid_file(const string &path);
+};
+
+
+#endif
@@ -0,0 +1,133 @@
+#include "grid_file.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+const string example = "4 3\n2 0 0 0\n0 0 0 0\n0 0 3 1\n";
+
+// the problem with text, or "" if it parses
+string problem(const string &text) {
+  istringstream is(text);
+  Grid g(0, 0);
+  string error;
+  return read_grid(is, g, error) ? "" : error;
+}
+
+string write_file(const string &contents) {
+  char path[] = "/tmp/grid_file_test.XXXXXX";
+  const int fd = mkstemp(path);
+  EXPECT_GE(fd, 0);
+  EXPECT_EQ((ssize_t)contents.size(), write(fd, contents.data(), contents.size()));
+  close(fd);
+  return path;
+}
+
+TEST(GridText, parses_quora_files) {
+  istringstream is(example);
+  Grid g(0, 0);
+  string error;
+  ASSERT_TRUE(read_grid(is, g, error));
+  EXPECT_EQ("200000000031", g.codes());
+  EXPECT_TRUE(g.have_start_and_end);
+  EXPECT_EQ(0u, g.start_idx);
+  EXPECT_EQ(10u, g.end_idx);
+
+  // the grid built cell by cell
+  Grid built(3, 4);
+  for(size_t cell = 0; cell < 12; ++cell) {
+    built.set_code(cell / 4, cell % 4, "200000000031"[cell] - '0');
+  }
+  built.have_start_and_end = true;
+  EXPECT_EQ(built.adjacency, g.adjacency);
+  EXPECT_EQ(built.start_idx, g.start_idx);
+  EXPECT_EQ(built.end_idx, g.end_idx);
+
+  EXPECT_EQ("", problem("2 1 1 1"));
+  EXPECT_EQ("", problem("3 1\t0 0 0 \r\n"));
+}
+
+TEST(GridText, reports_errors) {
+  EXPECT_EQ("line 1: the text ends before the width", problem(""));
+  EXPECT_EQ("line 1: the width is not a number", problem("x 3"));
+  EXPECT_EQ("line 1: the height is more than 255", problem("4 300"));
+  EXPECT_EQ("line 1: the grid is empty", problem("0 3"));
+  EXPECT_EQ("line 2: the code of cell (0,2) is more than 3", problem("4 3\n2 0 7 0"));
+  EXPECT_EQ("line 2: the code of cell (0,1) is not a number", problem("4 3\n2 -1"));
+  EXPECT_EQ("line 4: the text ends before the code of cell (2,3)", problem("4 3\n2 0 0 0\n0 0 0 0\n0 0 3\n"));
+  EXPECT_EQ("line 2: a second intake", problem("4 3\n2 0 2 0"));
+  EXPECT_EQ("line 3: a second AC", problem("2 2\n3 0\n0 3"));
+  EXPECT_EQ("line 3: an intake without an AC", problem("2 2\n2 0\n0 0"));
+  EXPECT_EQ("line 6: more after the grid", problem(example + "\n9"));
+}
+
+TEST(GridFile, round_trip) {
+  vector<string> texts = {example, "1 1 0", "3 2 1 1 1 1 1 1", "5 1 2 0 0 0 3"};
+  string big = "255 2";
+  for(int i = 0; i < 510; ++i) {
+    big += i == 0 ? " 2" : i == 509 ? " 3" : i % 7 == 3 ? " 1" : " 0";
+  }
+  texts.push_back(big);
+
+  string contents = grid_file_header();
+  vector<Grid> grids;
+  for(auto &text : texts) {
+    grids.push_back(parse(text));
+    contents += grid_record(grids.back());
+  }
+  const string path = write_file(contents);
+  EXPECT_TRUE(GridFile::is_grid_file(path));
+
+  GridFile file(path);
+  ASSERT_TRUE(file.ok());
+  Grid g(0, 0);
+  for(auto &expected : grids) {
+    ASSERT_TRUE(file.next(g));
+    EXPECT_EQ(expected.rows, g.rows);
+    EXPECT_EQ(expected.cols, g.cols);
+    EXPECT_EQ(expected.codes(), g.codes());
+    EXPECT_EQ(expected.have_start_and_end, g.have_start_and_end);
+    EXPECT_EQ(expected.adjacency, g.adjacency);
+  }
+  EXPECT_FALSE(file.next(g));
+  EXPECT_EQ("", file.error());
+  remove(path.c_str());
+}
+
+TEST(GridFile, rejects_damage) {
+  const string record = grid_record(parse(example));
+
+  // a flipped code bit, a cut record, and an AC moved in the codes only
+  string flipped = record;
+  flipped[sizeof(GridRecord) + 1] ^= 4;
+  string moved = record;
+  moved[sizeof(GridRecord) + 2] = 0x00;
+  moved[sizeof(GridRecord) + 1] = 0x03;
+
+  const vector<pair<string, string> > damaged = {
+    {flipped, "the record at byte 8 fails its checksum"},
+    {record.substr(0, record.size() - 1), "the record at byte 8 is cut short"},
+    {record + record.substr(0, 5), "the record at byte 23 is cut short"},
+  };
+  for(auto &contents_error : damaged) {
+    const string path = write_file(grid_file_header() + contents_error.first);
+    GridFile file(path);
+    ASSERT_TRUE(file.ok());
+    Grid g(0, 0);
+    while (file.next(g))
+      ;
+    EXPECT_EQ(contents_error.second, file.error());
+    remove(path.c_str());
+  }
+
+  const string text_path = write_file(example);
+  EXPECT_FALSE(GridFile::is_grid_file(text_path));
+  GridFile text(text_path);
+  EXPECT_FALSE(text.ok());
+  remove(text_path.c_str());
+}
@@ -0,0 +1,105 @@
+#ifndef __HISTOGRAM_HH__
+#define __HISTOGRAM_HH__
+
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "count_paths.hh"
+using namespace std;
+
+// Layouts counted by a statistic instead of in total: every state of the
+// row sweep carries the generating polynomial of its partial layouts, the
+// coefficient of x^k the number with statistic k so far.  A row adds its
+// own share k of the statistic, so a successor gets the polynomial times
+// x^k, the shift and add of simd's add_shifted.  The statistics:
+//   turns       rooms the duct bends in; a room with exactly one of its
+//               two segments horizontal
+//   horizontal  horizontal segments; the others, as many as the rooms
+//               less one, are vertical
+// Polynomials have a fixed number of coefficients, a power of two above
+// the number of rooms up to max_histogram_terms, and are truncated past
+// it.  Counts are modulo 2^64.
+enum layout_statistic_t { turns_statistic, horizontal_statistic };
+
+const size_t max_histogram_terms = 256;
+
+// the statistic of one row of a layout
+inline unsigned row_statistic(layout_statistic_t statistic,
+			      const vector<Grid::Node::degree_t> &target_degrees,
+			      const vector<bool> &hmask)
+{
+  unsigned k = 0;
+  for(size_t col = 0; col < hmask.size(); ++col) {
+    if (statistic == horizontal_statistic)
+      k += hmask[col];
+    else if (target_degrees[col] == 2)
+      k += ((col > 0 and hmask[col - 1]) + hmask[col]) == 1;
+  }
+  return k;
+}
+
+template<size_t N>
+struct Polynomial {
+  alignas(32) uint64_t coefficients[N];
+  Polynomial() { fill(coefficients, coefficients + N, 0); }
+};
+
+template<size_t N, class ConfigurationT>
+vector<uint64_t> histogram_sweep(const Grid &g, layout_statistic_t statistic) {
+  typedef unordered_map<ConfigurationT, Polynomial<N>, hash<ConfigurationT>, equal_to<ConfigurationT>,
+			page_allocator<pair<const ConfigurationT, Polynomial<N> > > > config_map_t;
+  const auto add_shifted = simd::kernels().add_shifted;
+
+  vector<Grid::Node::degree_t> target_degrees(g.cols, -1);
+  vector<vector<Grid::Node> > next_neighbors(g.cols);
+  config_map_t cur_configs, next_configs;
+  cur_configs[ConfigurationT(vector<int>(g.cols, 0))].coefficients[0] = 1;
+
+  for(auto row : range(g.rows)) {
+    row_setup(g, row, target_degrees, next_neighbors);
+    for(auto &config_polynomial : cur_configs) {
+      const uint64_t *from = config_polynomial.second.coefficients;
+      for_each_next_config<ConfigurationT>(row, config_polynomial.first, target_degrees, next_neighbors,
+        [&](const ConfigurationT &next_config, const vector<bool> &hmask, const vector<bool> &) {
+	  add_shifted(next_configs[next_config].coefficients, from, N,
+		      row_statistic(statistic, target_degrees, hmask));
+	});
+    }
+    swap(cur_configs, next_configs);
+    next_configs.clear();
+  }
+
+  vector<uint64_t> histogram(N, 0);
+  for(auto &config_polynomial : cur_configs) {
+    add_shifted(histogram.data(), config_polynomial.second.coefficients, N, 0);
+  }
+  while (not histogram.empty() and histogram.back() == 0)
+    histogram.pop_back();
+  return histogram;
+}
+
+inline size_t rooms(const Grid &g) {
+  size_t n = 0;
+  for(auto &node : g.nodes) {
+    n += node.target_degree > 0;
+  }
+  return n;
+}
+
+// The number of layouts with statistic k, for every k up to the last
+// with any; it sums to count_paths.
+template<class ConfigurationT>
+vector<uint64_t> layout_histogram(const Grid &g, layout_statistic_t statistic) {
+  const size_t terms = rooms(g) + 1;
+  if (terms <= 32)
+    return histogram_sweep<32, ConfigurationT>(g, statistic);
+  if (terms <= 64)
+    return histogram_sweep<64, ConfigurationT>(g, statistic);
+  if (terms <= 128)
+    return histogram_sweep<128, ConfigurationT>(g, statistic);
+  return histogram_sweep<max_histogram_terms, ConfigurationT>(g, statistic);
+}
+
+
+#endif
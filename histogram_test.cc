@@ -0,0 +1,153 @@
+#include "histogram.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <random>
+#include <sstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+// Every layout of g walked out cell by cell, tallied by turns and by
+// horizontal segments.
+struct BruteForce {
+  const Grid &g;
+  const string codes;
+  vector<bool> visited;
+  vector<int> path;
+  size_t rooms;
+  vector<uint64_t> by_turns, by_horizontal;
+
+  BruteForce(const Grid &g) : g(g), codes(g.codes()), visited(codes.size()), rooms(0) {
+    for(auto code : codes) {
+      rooms += code != '1';
+    }
+    const int start = codes.find('2');
+    visited[start] = true;
+    path.push_back(start);
+    walk();
+  }
+
+  void tally() {
+    size_t turns = 0, horizontal = 0;
+    for(size_t i = 1; i < path.size(); ++i) {
+      const bool across = path[i] / g.cols == path[i - 1] / g.cols;
+      horizontal += across;
+      if (i + 1 < path.size())
+	turns += across != (path[i + 1] / g.cols == path[i] / g.cols);
+    }
+    by_turns.resize(max(by_turns.size(), turns + 1));
+    ++by_turns[turns];
+    by_horizontal.resize(max(by_horizontal.size(), horizontal + 1));
+    ++by_horizontal[horizontal];
+  }
+
+  void walk() {
+    const int cell = path.back(), row = cell / g.cols, col = cell % g.cols;
+    if (codes[cell] == '3') {
+      if (path.size() == rooms)
+	tally();
+      return;
+    }
+    const int steps[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+    for(auto &step : steps) {
+      const int r = row + step[0], c = col + step[1], next = r * g.cols + c;
+      if (r < 0 or r >= (int)g.rows or c < 0 or c >= (int)g.cols or codes[next] == '1' or visited[next])
+	continue;
+      visited[next] = true;
+      path.push_back(next);
+      walk();
+      path.pop_back();
+      visited[next] = false;
+    }
+  }
+};
+
+TEST(Histogram, shifted_adds) {
+  vector<const simd::Kernels *> available{&simd::scalar_kernels};
+  if (simd::have_sse42())
+    available.push_back(&simd::sse42_kernels);
+  if (simd::have_avx2())
+    available.push_back(&simd::avx2_kernels);
+
+  mt19937_64 rng(44);
+  for(auto kernels : available) {
+    for(size_t n : {1, 3, 4, 7, 32, 33}) {
+      for(unsigned shift : {0u, 1u, 2u, 5u, (unsigned)n, (unsigned)n + 3}) {
+	vector<uint64_t> from(n), to(n);
+	for(size_t i = 0; i < n; ++i) {
+	  from[i] = rng();
+	  to[i] = rng();
+	}
+	vector<uint64_t> expected(to);
+	for(size_t i = 0; i + shift < n; ++i) {
+	  expected[i + shift] += from[i];
+	}
+	kernels->add_shifted(to.data(), from.data(), n, shift);
+	EXPECT_EQ(expected, to) << kernels->name << " " << n << " " << shift;
+      }
+    }
+  }
+}
+
+TEST(Histogram, small_grids) {
+  // the two layouts of test.quora, one with four turns and one with six
+  const Grid g = parse("4 3  2 0 0 0  0 0 0 0  0 0 3 1");
+  EXPECT_EQ((vector<uint64_t>{0, 0, 0, 0, 1, 0, 1}), layout_histogram<VectorConfig>(g, turns_statistic));
+  EXPECT_EQ((vector<uint64_t>{0, 0, 0, 0, 1, 0, 0, 0, 1}),
+	    layout_histogram<VectorConfig>(g, horizontal_statistic));
+
+  // a straight corridor: no turns, all of it horizontal
+  EXPECT_EQ((vector<uint64_t>{1}), layout_histogram<VectorConfig>(parse("4 1  2 0 0 3"), turns_statistic));
+  EXPECT_EQ((vector<uint64_t>{0, 0, 0, 1}),
+	    layout_histogram<VectorConfig>(parse("4 1  2 0 0 3"), horizontal_statistic));
+
+  // no layouts at all
+  EXPECT_TRUE(layout_histogram<VectorConfig>(parse("2 2  2 1 1 3"), turns_statistic).empty());
+}
+
+TEST(Histogram, matches_brute_force) {
+  mt19937 rng(44);
+  int with_layouts = 0;
+  for(int i = 0; i < 300; ++i) {
+    const int cols = 1 + rng() % 5, rows = 1 + rng() % 5, cells = cols * rows;
+    if (cells < 2)
+      continue;
+    vector<int> codes(cells);
+    for(auto &code : codes) {
+      code = rng() % 6 == 0;
+    }
+    const int start = rng() % cells;
+    int end = rng() % (cells - 1);
+    end += end >= start;
+    codes[start] = 2;
+    codes[end] = 3;
+    ostringstream text;
+    text << cols << " " << rows;
+    for(auto code : codes) {
+      text << " " << code;
+    }
+    const Grid g = parse(text.str());
+
+    BruteForce brute(g);
+    with_layouts += not brute.by_turns.empty();
+    EXPECT_EQ(brute.by_turns, layout_histogram<VectorConfig>(g, turns_statistic)) << text.str();
+    EXPECT_EQ(brute.by_horizontal, layout_histogram<VectorConfig>(g, horizontal_statistic)) << text.str();
+  }
+  EXPECT_LT(30, with_layouts);
+}
+
+TEST(Histogram, sums_to_the_count) {
+  // wide enough for 64 term polynomials
+  const Grid g = open_grid(7, 6);
+  const uint64_t count = semiring_paths<CountSemiring<uint64_t>, VectorConfig>(g);
+  EXPECT_LT(0u, count);
+  for(auto statistic : {turns_statistic, horizontal_statistic}) {
+    const vector<uint64_t> histogram = layout_histogram<VectorConfig>(g, statistic);
+    uint64_t sum = 0;
+    for(auto c : histogram) {
+      sum += c;
+    }
+    EXPECT_EQ(count, sum);
+  }
+}
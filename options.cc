@@ -0,0 +1,281 @@
+#include "options.hh"
+
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <thread>
+
+Options::Options() :
+  repeat(1),
+  aggregate("hash"),
+  threads(thread::hardware_concurrency()),
+  processes(0),
+  engine("auto"),
+  graph(false),
+  order("auto"),
+  decompose(false),
+  samples(0),
+  semiring("count"),
+  plan(false),
+  transpose(false),
+  flip(false),
+  transfer(false),
+  modulus(0),
+  symmetry(false),
+  batch(false),
+  estimate(0),
+  runs(0),
+  seed(0),
+  pages("standard"),
+  page_stats(false),
+  counters(false)
+{}
+
+bool Options::parse(int argc, char *argv[]) {
+  vector<string> positional;
+
+  for(int i = 1; i < argc; ++i) {
+    const string arg(argv[i]);
+
+    const auto value = [&]() -> const char * {
+      if (i + 1 >= argc) {
+	cerr << arg << " needs a value" << endl;
+	return nullptr;
+      }
+      return argv[++i];
+    };
+
+    if (arg == "--aggregate") {
+      const char *v = value();
+      if (not v)
+	return false;
+      aggregate = v;
+      if (aggregate != "hash" and aggregate != "sort") {
+	cerr << "--aggregate must be hash or sort" << endl;
+	return false;
+      }
+    } else if (arg == "--threads") {
+      const char *v = value();
+      if (not v)
+	return false;
+      threads = max(atoi(v), 1);
+    } else if (arg == "--processes") {
+      const char *v = value();
+      if (not v)
+	return false;
+      processes = max(atoi(v), 1);
+    } else if (arg == "--engine") {
+      const char *v = value();
+      if (not v)
+	return false;
+      engine = v;
+      if (engine != "auto" and engine != "dp" and engine != "dfs") {
+	cerr << "--engine must be auto, dp or dfs" << endl;
+	return false;
+      }
+    } else if (arg == "--graph") {
+      graph = true;
+    } else if (arg == "--order") {
+      const char *v = value();
+      if (not v)
+	return false;
+      order = v;
+    } else if (arg == "--zdd") {
+      const char *v = value();
+      if (not v)
+	return false;
+      zdd_file = v;
+    } else if (arg == "--sample") {
+      const char *v = value();
+      if (not v)
+	return false;
+      samples = atoi(v);
+    } else if (arg == "--semiring") {
+      const char *v = value();
+      if (not v)
+	return false;
+      semiring = v;
+      if (semiring != "count" and semiring != "exists" and semiring != "min" and semiring != "max") {
+	cerr << "--semiring must be count, exists, min or max" << endl;
+	return false;
+      }
+    } else if (arg == "--costs") {
+      const char *v = value();
+      if (not v)
+	return false;
+      costs_file = v;
+    } else if (arg == "--progress") {
+      const char *v = value();
+      if (not v)
+	return false;
+      limits.progress_interval = atof(v);
+    } else if (arg == "--status-file") {
+      const char *v = value();
+      if (not v)
+	return false;
+      limits.status_file = v;
+    } else if (arg == "--time-limit") {
+      const char *v = value();
+      if (not v)
+	return false;
+      limits.time_limit = atof(v);
+    } else if (arg == "--memory-limit") {
+      const char *v = value();
+      if (not v)
+	return false;
+      limits.memory_limit = (size_t)(atof(v) * (1 << 20));
+    } else if (arg == "--snapshot") {
+      const char *v = value();
+      if (not v)
+	return false;
+      limits.snapshot_file = v;
+    } else if (arg == "--resume") {
+      const char *v = value();
+      if (not v)
+	return false;
+      limits.resume_file = v;
+    } else if (arg == "--decompose") {
+      decompose = true;
+    } else if (arg == "--plan") {
+      plan = true;
+    } else if (arg == "--orientation") {
+      const char *v = value();
+      if (not v)
+	return false;
+      const string o = v;
+      if (o != "given" and o != "flipped" and o != "transposed" and o != "transposed-flipped") {
+	cerr << "--orientation must be given, flipped, transposed or transposed-flipped" << endl;
+	return false;
+      }
+      transpose = o.compare(0, 10, "transposed") == 0;
+      flip = o == "flipped" or o == "transposed-flipped";
+    } else if (arg == "--transfer") {
+      transfer = true;
+    } else if (arg == "--modulus") {
+      const char *v = value();
+      if (not v)
+	return false;
+      modulus = strtoull(v, nullptr, 10);
+    } else if (arg == "--histogram") {
+      const char *v = value();
+      if (not v)
+	return false;
+      histogram = v;
+      if (histogram != "turns" and histogram != "horizontal") {
+	cerr << "--histogram must be turns or horizontal" << endl;
+	return false;
+      }
+    } else if (arg == "--symmetry") {
+      symmetry = true;
+    } else if (arg == "--batch") {
+      batch = true;
+    } else if (arg == "--estimate") {
+      const char *v = value();
+      if (not v)
+	return false;
+      estimate = max(atoll(v), 1ll);
+    } else if (arg == "--runs") {
+      const char *v = value();
+      if (not v)
+	return false;
+      runs = max(atoll(v), 2ll);
+    } else if (arg == "--seed") {
+      const char *v = value();
+      if (not v)
+	return false;
+      seed = strtoull(v, nullptr, 10);
+    } else if (arg == "--cache") {
+      const char *v = value();
+      if (not v)
+	return false;
+      cache_dir = v;
+    } else if (arg == "--pages") {
+      const char *v = value();
+      if (not v)
+	return false;
+      pages = v;
+      if (pages != "standard" and pages != "thp" and pages != "huge") {
+	cerr << "--pages must be standard, thp or huge" << endl;
+	return false;
+      }
+    } else if (arg == "--page-stats") {
+      page_stats = true;
+    } else if (arg == "--counters") {
+      counters = true;
+    } else if (arg == "--help") {
+      usage(cout);
+      exit(0);
+    } else if (arg.size() > 1 and arg[0] == '-') {
+      cerr << "Unknown option '" << arg << "'" << endl;
+      usage(cerr);
+      return false;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if ((not limits.snapshot_file.empty() or not limits.resume_file.empty()) and semiring != "count") {
+    cerr << "--snapshot and --resume only work with --semiring count" << endl;
+    return false;
+  }
+  if (positional.size() > 2) {
+    usage(cerr);
+    return false;
+  }
+  if (positional.size() > 0)
+    input = positional[0];
+  if (positional.size() > 1)
+    repeat = atoi(positional[1].c_str());
+
+  return true;
+}
+
+bool Options::controlled() const {
+  return (limits.progress_interval > 0 or limits.time_limit > 0 or limits.memory_limit > 0 or
+	  not limits.resume_file.empty());
+}
+
+void Options::usage(ostream &os) {
+  os << "usage: count [options] [grid-file [repeat]]" << endl
+     << "  --aggregate A  merge row states by hash (default) or sort" << endl
+     << "  --threads N    worker threads (default: all cores)" << endl
+     << "  --processes N  shard the row sweep over N worker processes" << endl
+     << "  --engine E     count by row sweep (dp), depth first search (dfs) or" << endl
+     << "                 whichever suits the grid (auto, the default)" << endl
+     << "  --graph        read an edge-list graph instead of a grid" << endl
+     << "  --order METHOD vertex order for --graph: auto, natural, cm, rcm, greedy" << endl
+     << "  --decompose    split the plan where it is narrow and count the parts" << endl
+     << "                 separately, as a graph" << endl
+     << "  --zdd FILE     build the ZDD of all paths and save it to FILE" << endl
+     << "  --sample N     print N uniformly random paths (builds the ZDD)" << endl
+     << "  --semiring S   count layouts (default), check one exists, or find the" << endl
+     << "                 min or max cost layout and print its segments" << endl
+     << "  --costs FILE   cell and segment costs for min and max (default: all zero)" << endl
+     << "  --progress S   report rows, states, throughput and eta every S seconds" << endl
+     << "  --status-file F write the progress reports to F instead of stderr" << endl
+     << "  --time-limit S stop the row sweep cleanly after S seconds" << endl
+     << "  --memory-limit M" << endl
+     << "                 or once M MiB are resident" << endl
+     << "  --snapshot F   on such a stop save the sweep's states to F" << endl
+     << "  --resume F     continue the sweep saved in F" << endl
+     << "  --plan         predict states, memory and time per orientation and engine" << endl
+     << "  --orientation O  sweep the grid given, flipped, transposed or transposed-flipped" << endl
+     << "  --transfer     power the transfer matrix of long runs of identical rows" << endl
+     << "  --modulus M    with --transfer, count modulo M (default: 2^64)" << endl
+     << "  --histogram S  count layouts by their turns, or by their horizontal" << endl
+     << "                 and vertical segments" << endl
+     << "  --symmetry     keep one of each pair of mirrored states while the rows" << endl
+     << "                 swept, or those left, are left-right symmetric" << endl
+     << "  --batch        count every grid of the input, text or grid file, one" << endl
+     << "                 per line; grids with the same first rows share them" << endl
+     << "  --estimate K   estimate the count with a 95% interval from sweeps that" << endl
+     << "                 keep a weighted sample of K states a row" << endl
+     << "  --runs N       sweeps of the estimate (default: 32, or as many as" << endl
+     << "                 --time-limit allows)" << endl
+     << "  --seed S       seed of the estimate's sampling" << endl
+     << "  --cache DIR    reuse counts of this grid or its mirror images from DIR" << endl
+     << "  --pages P      back the state tables by standard, thp or huge pages" << endl
+     << "  --page-stats   report mappings, page faults and dTLB misses on stderr" << endl
+     << "  --counters     report cycles, instructions, cache, branch and dTLB misses" << endl
+     << "                 of the row setup, expansion and aggregation on stderr" << endl;
+}
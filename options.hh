@@ -0,0 +1,67 @@
+#ifndef __OPTIONS_HH__
+#define __OPTIONS_HH__
+
+#include <string>
+#include <iostream>
+#include <stdint.h>
+#include "sweep_control.hh"
+using namespace std;
+
+// Command line of the count binary:
+//   count [options] [grid-file [repeat]]
+// With no grid file the grid is read from stdin.
+struct Options {
+  string input;
+  int repeat;
+
+  string aggregate;    // --aggregate hash|sort: how the row sweep merges states
+  unsigned threads;    // --threads N: worker threads where an engine has them
+  unsigned processes;  // --processes N: shard the sweep over N worker processes, see sharded.hh
+  string engine;       // --engine auto|dp|dfs: row sweep or depth first search, see dfs.hh
+
+  bool graph;          // --graph: the input is an edge list, see graph.hh
+  string order;        // --order METHOD: vertex order for --graph, see ordering.hh
+  bool decompose;      // --decompose: split at cut vertices and two-vertex separators first
+
+  string zdd_file;     // --zdd FILE: build the path ZDD and save it
+  unsigned samples;    // --sample N: print N uniformly random paths
+
+  string semiring;     // --semiring count|exists|min|max: what the row sweep computes
+  string costs_file;   // --costs FILE: cell and segment costs for min and max, see costs.hh
+
+  SweepLimits limits;  // --progress SECONDS, --status-file FILE, --time-limit SECONDS,
+                       // --memory-limit MB, --snapshot FILE, --resume FILE
+
+  bool plan;           // --plan: predict states, memory and time instead of counting
+  bool transpose, flip;  // --orientation given|flipped|transposed|transposed-flipped
+
+  bool transfer;       // --transfer: power the transfer matrix of runs of identical rows
+  uint64_t modulus;    // --modulus M: count modulo M with --transfer, 0 for 2^64
+
+  string histogram;    // --histogram turns|horizontal: layouts by statistic, see histogram.hh
+  bool symmetry;       // --symmetry: fold mirrored states of the sweep, see symmetry.hh
+  bool batch;          // --batch: count every grid of the input, sharing leading rows, see batch.hh
+
+  size_t estimate;     // --estimate K: estimate the count, K states a row, see estimate.hh
+  size_t runs;         // --runs N: sampled sweeps of the estimate, 0 for as many as the time limit allows
+  uint64_t seed;       // --seed S: of the estimate, 0 for a random one
+
+  string cache_dir;    // --cache DIR: look counts up in and add them to a result cache
+
+  string pages;        // --pages standard|thp|huge: backing of the state tables, see page_alloc.hh
+  bool page_stats;     // --page-stats: report mappings, faults and TLB misses on stderr
+  bool counters;       // --counters: report hardware counters per sweep phase on stderr
+
+  Options();
+
+  // whether the row sweep runs under a SweepControl
+  bool controlled() const;
+
+  // false (after printing the problem) on a malformed command line
+  bool parse(int argc, char *argv[]);
+
+  static void usage(ostream &os);
+};
+
+
+#endif
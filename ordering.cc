@@ -0,0 +1,196 @@
+#include "ordering.hh"
+
+#include <algorithm>
+#include <numeric>
+#include <deque>
+#include <set>
+#include <limits>
+#include <cassert>
+#include "range.hh"
+
+namespace {
+  // breadth first distances from start within its component; -1 elsewhere
+  vector<int> bfs_distances(const Graph &g, Graph::index_t start) {
+    vector<int> distance(g.size(), -1);
+    deque<Graph::index_t> queue{start};
+    distance[start] = 0;
+    while (not queue.empty()) {
+      auto v = queue.front();
+      queue.pop_front();
+      for(auto w : g.adjacency[v]) {
+	if (distance[w] < 0) {
+	  distance[w] = distance[v] + 1;
+	  queue.push_back(w);
+	}
+      }
+    }
+    return distance;
+  }
+
+  // George & Liu: walk to a farthest minimum-degree vertex until the
+  // eccentricity stops growing
+  Graph::index_t pseudo_peripheral(const Graph &g, Graph::index_t seed) {
+    Graph::index_t v = seed;
+    int eccentricity = -1;
+    for(;;) {
+      vector<int> distance = bfs_distances(g, v);
+      int far = *max_element(begin(distance), end(distance));
+      if (far <= eccentricity)
+	return v;
+      eccentricity = far;
+
+      Graph::index_t best = v;
+      for(auto w : range(g.size())) {
+	if (distance[w] == far and
+	    (best == v or g.adjacency[w].size() < g.adjacency[best].size()))
+	  best = w;
+      }
+      v = best;
+    }
+  }
+}
+
+size_t frontier_width(const Graph &g, const vertex_order_t &order) {
+  assert(order.size() == g.size());
+  vector<bool> visited(g.size(), false);
+  long cut = 0, widest = 0;
+  for(auto v : order) {
+    for(auto w : g.adjacency[v]) {
+      cut += visited[w] ? -1 : 1;
+    }
+    visited[v] = true;
+    widest = max(widest, cut);
+  }
+  return widest;
+}
+
+vertex_order_t natural_order(const Graph &g) {
+  vertex_order_t order(g.size());
+  iota(begin(order), end(order), 0);
+  return order;
+}
+
+vertex_order_t cuthill_mckee(const Graph &g, Graph::index_t start) {
+  vertex_order_t order;
+  vector<bool> visited(g.size(), false);
+
+  const auto by_degree = [&](Graph::index_t a, Graph::index_t b) {
+    return g.adjacency[a].size() < g.adjacency[b].size();
+  };
+
+  for(size_t component = 0; order.size() < g.size(); ) {
+    Graph::index_t root;
+    if (order.empty()) {
+      root = start;
+    } else {
+      while (visited[component])
+	++component;
+      root = pseudo_peripheral(g, component);
+    }
+
+    size_t head = order.size();
+    order.push_back(root);
+    visited[root] = true;
+    for(; head < order.size(); ++head) {
+      vector<Graph::index_t> next;
+      for(auto w : g.adjacency[order[head]]) {
+	if (not visited[w]) {
+	  visited[w] = true;
+	  next.push_back(w);
+	}
+      }
+      stable_sort(begin(next), end(next), by_degree);
+      order.insert(end(order), begin(next), end(next));
+    }
+  }
+
+  return order;
+}
+
+vertex_order_t greedy_frontier_order(const Graph &g, Graph::index_t start) {
+  vertex_order_t order;
+  vector<bool> visited(g.size(), false);
+  vector<int> visited_neighbors(g.size(), 0);
+  set<Graph::index_t> candidates;
+
+  const auto growth = [&](Graph::index_t v) {
+    return (int)g.adjacency[v].size() - 2 * visited_neighbors[v];
+  };
+
+  while (order.size() < g.size()) {
+    Graph::index_t v;
+    if (order.empty()) {
+      v = start;
+    } else if (candidates.empty()) {
+      // a new component: start it where the cut grows least
+      v = g.size();
+      for(auto w : range(g.size())) {
+	if (not visited[w] and (v == g.size() or g.adjacency[w].size() < g.adjacency[v].size()))
+	  v = w;
+      }
+    } else {
+      v = *begin(candidates);
+      for(auto w : candidates) {
+	if (growth(w) < growth(v) or
+	    (growth(w) == growth(v) and visited_neighbors[w] > visited_neighbors[v]))
+	  v = w;
+      }
+    }
+
+    order.push_back(v);
+    visited[v] = true;
+    candidates.erase(v);
+    for(auto w : g.adjacency[v]) {
+      ++visited_neighbors[w];
+      if (not visited[w])
+	candidates.insert(w);
+    }
+  }
+
+  return order;
+}
+
+vertex_order_t plan_order(const Graph &g, const string &method) {
+  if (g.size() == 0)
+    return vertex_order_t();
+
+  const Graph::index_t peripheral = pseudo_peripheral(g, 0);
+
+  if (method == "natural")
+    return natural_order(g);
+  if (method == "cm")
+    return cuthill_mckee(g, peripheral);
+  if (method == "rcm") {
+    vertex_order_t order = cuthill_mckee(g, peripheral);
+    reverse(begin(order), end(order));
+    return order;
+  }
+  if (method == "greedy")
+    return greedy_frontier_order(g, peripheral);
+  if (method != "auto")
+    return vertex_order_t();
+
+  vector<Graph::index_t> starts{peripheral, 0};
+  if (g.have_start_and_end) {
+    starts.push_back(g.start_idx);
+    starts.push_back(g.end_idx);
+  }
+
+  vector<vertex_order_t> candidates{natural_order(g)};
+  for(auto start : starts) {
+    candidates.push_back(cuthill_mckee(g, start));
+    candidates.push_back(candidates.back());
+    reverse(begin(candidates.back()), end(candidates.back()));
+    candidates.push_back(greedy_frontier_order(g, start));
+  }
+
+  size_t best = 0, best_width = numeric_limits<size_t>::max();
+  for(auto i : range(candidates.size())) {
+    size_t width = frontier_width(g, candidates[i]);
+    if (width < best_width) {
+      best = i;
+      best_width = width;
+    }
+  }
+  return candidates[best];
+}
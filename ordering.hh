@@ -0,0 +1,32 @@
+#ifndef __ORDERING_HH__
+#define __ORDERING_HH__
+
+#include <string>
+#include <vector>
+#include "graph.hh"
+using namespace std;
+
+// Vertex orders for the frontier sweep.  The sweep's state is a
+// Configuration over the edges crossing the visited/unvisited cut, so its
+// cost is governed by the widest such cut along the order.
+
+typedef vector<Graph::index_t> vertex_order_t;
+
+// the largest number of edges crossing the cut, i.e. FrontierPlan::slots
+size_t frontier_width(const Graph &g, const vertex_order_t &order);
+
+vertex_order_t natural_order(const Graph &g);
+
+// breadth first from start, neighbours by increasing degree; every other
+// component follows from its own pseudo-peripheral vertex
+vertex_order_t cuthill_mckee(const Graph &g, Graph::index_t start);
+
+// repeatedly visits the vertex that grows the cut least
+vertex_order_t greedy_frontier_order(const Graph &g, Graph::index_t start);
+
+// one of "natural", "cm", "rcm", "greedy" or "auto" (the narrowest of all
+// of them from a few start vertices); empty if the method is unknown
+vertex_order_t plan_order(const Graph &g, const string &method);
+
+
+#endif
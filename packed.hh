@@ -0,0 +1,74 @@
+#ifndef __PACKED_HH__
+#define __PACKED_HH__
+
+#include <vector>
+#include <cassert>
+#include <stdint.h>
+#include "configuration.hh"
+#include "range.hh"
+using namespace std;
+
+// Row sweep configurations of a planar grid never cross, so each column
+// fits in two bits: 0 unused, 1 opens a path fragment, 2 closes the most
+// recently opened one, 3 leads to an endpoint.  Column 0 is the low bits.
+// The keys are dense, hash cheaply and sort with a radix sort.
+typedef uint64_t packed_config_t;
+
+static const size_t max_packed_cols = 32;
+
+template<class ConfigurationT>
+packed_config_t pack_configuration(const ConfigurationT &config) {
+  assert(config.size() <= max_packed_cols);
+  const unsigned lanes = simd_lanes<decltype(config.config)>::value;
+  if (lanes) {
+    return simd::kernels().pack((const uint16_t *)config.config.data(), lanes);
+  }
+
+  packed_config_t key = 0;
+  for(size_t col = config.size(); col-- > 0; ) {
+    const auto partner = config.config[col];
+    packed_config_t code;
+    if (partner == ConfigurationT::no_partner)
+      code = 0;
+    else if (partner == col)
+      code = 3;
+    else if (partner > col)
+      code = 1;
+    else
+      code = 2;
+    key = (key << 2) | code;
+  }
+  return key;
+}
+
+template<class ConfigurationT>
+ConfigurationT unpack_configuration(packed_config_t key, size_t cols) {
+  assert(cols <= max_packed_cols);
+  ConfigurationT config(vector<int>(cols, 0));
+  size_t open[max_packed_cols];
+  size_t depth = 0;
+
+  for(auto col : range(cols)) {
+    switch((key >> (2 * col)) & 3) {
+    case 1:
+      open[depth++] = col;
+      break;
+    case 2:
+      assert(depth > 0);
+      --depth;
+      config.config[col] = open[depth];
+      config.config[open[depth]] = col;
+      break;
+    case 3:
+      config.config[col] = col;
+      break;
+    }
+  }
+
+  assert(depth == 0);
+  assert(config.sanity_check());
+  return config;
+}
+
+
+#endif
@@ -0,0 +1,275 @@
+#include "page_alloc.hh"
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <cstdlib>
+#include <tuple>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace pages {
+  namespace {
+    atomic<int> current_backing(standard);
+
+    atomic<size_t> maps(0), mapped_bytes(0), peak_bytes(0);
+    atomic<size_t> hugetlb_maps(0), hugetlb_fallbacks(0), local_maps(0), slabs(0);
+
+    // while a Report is open every mapping samples AnonHugePages, since
+    // the tables are gone by the time it is printed
+    atomic<bool> sampling(false);
+    atomic<size_t> peak_thp_kib(0);
+
+    void update_peak(atomic<size_t> &peak, size_t now) {
+      size_t seen = peak;
+      while (now > seen and not peak.compare_exchange_weak(seen, now)) {}
+    }
+
+    size_t anon_huge_kib() {
+      ifstream smaps("/proc/self/smaps_rollup");
+      string line;
+      while (getline(smaps, line)) {
+	if (line.compare(0, 14, "AnonHugePages:") == 0)
+	  return atol(line.c_str() + 14);
+      }
+      return 0;
+    }
+
+    const size_t page_bytes = 4096;
+    const int mpol_preferred = 1;  // MPOL_PREFERRED of <numaif.h>
+
+    // asks for the pages to come from the node of the calling cpu
+    bool bind_local(void *p, size_t length) {
+#if defined(SYS_getcpu) && defined(SYS_mbind)
+      unsigned cpu = 0, node = 0;
+      if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 or node >= 64)
+	return false;
+      unsigned long nodemask = 1ul << node;
+      return syscall(SYS_mbind, p, length, mpol_preferred, &nodemask, 64, 0) == 0;
+#else
+      (void)p, (void)length;
+      return false;
+#endif
+    }
+
+    void note_mapped(size_t length) {
+      ++maps;
+      update_peak(peak_bytes, mapped_bytes += length);
+      if (sampling)
+	update_peak(peak_thp_kib, anon_huge_kib());
+    }
+
+    size_t mapped_length(size_t bytes) {
+      return (bytes + huge_page_bytes - 1) / huge_page_bytes * huge_page_bytes;
+    }
+
+    bool mapped(size_t bytes) {
+      return current_backing != standard and bytes >= min_bytes;
+    }
+
+    bool node(size_t bytes) {
+      return current_backing != standard and bytes <= max_node_bytes;
+    }
+
+    // length bytes of the current backing, local and touched
+    void *map_pages(size_t length) {
+      void *p = MAP_FAILED;
+
+      if (backing() == huge) {
+	p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (p == MAP_FAILED)
+	  ++hugetlb_fallbacks;
+	else
+	  ++hugetlb_maps;
+      }
+      if (p == MAP_FAILED) {
+	p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+	  throw bad_alloc();
+	madvise(p, length, MADV_HUGEPAGE);
+      }
+
+      if (bind_local(p, length))
+	++local_maps;
+
+      // first touch by the thread that will fill the table
+      for(size_t offset = 0; offset < length; offset += page_bytes) {
+	static_cast<volatile char *>(p)[offset] = 0;
+      }
+
+      note_mapped(length);
+      return p;
+    }
+
+    // Nodes come in sizes of multiples of node_align bytes, each size
+    // with its own list of freed nodes, linked through their first bytes.
+    const size_t node_align = 16, max_node_align = 32;
+    const size_t node_sizes = max_node_bytes / node_align;
+
+    size_t node_size(size_t bytes) {
+      return (max<size_t>(bytes, 1) + node_align - 1) / node_align;
+    }
+
+    struct FreeNode {
+      FreeNode *next;
+    };
+
+    // what threads that ended left behind: lists of freed nodes by size,
+    // and the unused ends of their slabs
+    mutex left_mutex;
+    vector<FreeNode *> left_nodes[node_sizes + 1];
+    vector<pair<char *, char *> > left_slabs;
+
+    struct Slabs {
+      char *next, *end;  // the unused end of the current slab
+      FreeNode *freed[node_sizes + 1];
+
+      Slabs() : next(nullptr), end(nullptr) {
+	fill(freed, freed + node_sizes + 1, nullptr);
+      }
+
+      ~Slabs() {
+	lock_guard<mutex> lock(left_mutex);
+	for(size_t size = 1; size <= node_sizes; ++size) {
+	  if (freed[size])
+	    left_nodes[size].push_back(freed[size]);
+	}
+	if (next != end)
+	  left_slabs.emplace_back(next, end);
+      }
+
+      void *allocate(size_t size) {
+	if (freed[size]) {
+	  FreeNode *n = freed[size];
+	  freed[size] = n->next;
+	  return n;
+	}
+	const size_t bytes = size * node_align;
+	if (not fits(bytes)) {
+	  refill(size);
+	  if (freed[size])
+	    return allocate(size);
+	}
+	next = aligned(next, bytes);
+	void *p = next;
+	next += bytes;
+	return p;
+      }
+
+      // nodes of over-aligned types come in multiples of their alignment
+      static char *aligned(char *p, size_t bytes) {
+	const size_t align = bytes % max_node_align == 0 ? max_node_align : node_align;
+	return p + (align - (uintptr_t)p % align) % align;
+      }
+
+      bool fits(size_t bytes) const {
+	return next and (size_t)(end - next) >= bytes + max_node_align;
+      }
+
+      // the nodes of size another thread left, else a fresh slab
+      void refill(size_t size) {
+	{
+	  lock_guard<mutex> lock(left_mutex);
+	  if (not left_nodes[size].empty()) {
+	    freed[size] = left_nodes[size].back();
+	    left_nodes[size].pop_back();
+	    return;
+	  }
+	  if (not left_slabs.empty()) {
+	    tie(next, end) = left_slabs.back();
+	    left_slabs.pop_back();
+	    if (fits(size * node_align))
+	      return;
+	  }
+	}
+	next = static_cast<char *>(map_pages(huge_page_bytes));
+	end = next + huge_page_bytes;
+	++slabs;
+      }
+
+      void deallocate(void *p, size_t size) {
+	FreeNode *n = static_cast<FreeNode *>(p);
+	n->next = freed[size];
+	freed[size] = n;
+      }
+    };
+
+    thread_local Slabs thread_slabs;
+  }
+
+  void set_backing(backing_t b) { current_backing = b; }
+  backing_t backing() { return (backing_t)current_backing.load(); }
+
+  bool parse_backing(const string &name, backing_t &b) {
+    for(auto candidate : {standard, transparent, huge}) {
+      if (name == backing_name(candidate)) {
+	b = candidate;
+	return true;
+      }
+    }
+    return false;
+  }
+
+  const char *backing_name(backing_t b) {
+    return b == standard ? "standard" : b == transparent ? "thp" : "huge";
+  }
+
+  void *allocate(size_t bytes) {
+    if (node(bytes))
+      return thread_slabs.allocate(node_size(bytes));
+    if (not mapped(bytes))
+      return ::operator new(bytes);
+    return map_pages(mapped_length(bytes));
+  }
+
+  void deallocate(void *p, size_t bytes) {
+    if (node(bytes)) {
+      thread_slabs.deallocate(p, node_size(bytes));
+      return;
+    }
+    if (not mapped(bytes)) {
+      ::operator delete(p);
+      return;
+    }
+
+    const size_t length = mapped_length(bytes);
+    munmap(p, length);
+    mapped_bytes -= length;
+  }
+
+  Report::Report(ostream &os) :
+    os(os),
+    tlb_misses(counters::dtlb_misses)
+  {
+    sampling = true;
+  }
+
+  Report::~Report() {
+    const size_t mib = 1 << 20;
+    sampling = false;
+
+    os << "pages: " << backing_name(backing()) << ", " << maps << " mappings, peak "
+       << peak_bytes / mib << " MiB, " << slabs << " of them node slabs, " << local_maps
+       << " bound to the local node";
+    if (backing() == huge)
+      os << ", " << hugetlb_maps << " hugetlb, " << hugetlb_fallbacks << " fell back to thp";
+    os << endl;
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    os << "pages: " << usage.ru_minflt << " minor faults, " << usage.ru_majflt << " major faults, "
+       << "peak " << peak_thp_kib / 1024 << " MiB in transparent huge pages" << endl;
+
+    os << "pages: dTLB load misses ";
+    if (tlb_misses.available())
+      os << tlb_misses.count() << endl;
+    else
+      os << "unavailable" << endl;
+  }
+}
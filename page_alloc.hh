@@ -0,0 +1,76 @@
+#ifndef __PAGE_ALLOC_HH__
+#define __PAGE_ALLOC_HH__
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include "counters.hh"
+using namespace std;
+
+// Backing store for the big frontier tables.  With standard backing
+// everything goes through operator new.  Otherwise every allocation of at
+// least min_bytes gets its own mapping, rounded up to whole 2 MiB pages:
+//
+//   thp   anonymous memory advised to use transparent huge pages
+//   huge  explicit MAP_HUGETLB pages, falling back to thp when the
+//         kernel has none reserved
+//
+// Allocations of at most max_node_bytes, the nodes of the hash tables,
+// come from 2 MiB slabs mapped the same way.  Every thread carves its own
+// slabs and keeps the nodes it frees for reuse; a thread that ends leaves
+// them to the others.  Slabs are kept until the process exits.  What lies
+// in between, the bucket arrays of small tables, goes to operator new.
+//
+// The mapping prefers the NUMA node of the cpu that allocates it, and that
+// thread touches every page before handing it out, so a worker's shard
+// lives next to the worker.
+namespace pages {
+  enum backing_t { standard, transparent, huge };
+
+  const size_t min_bytes = 1 << 20;
+  const size_t max_node_bytes = 4096;
+  const size_t huge_page_bytes = 2 << 20;
+
+  // set once, before the first allocation
+  void set_backing(backing_t b);
+  backing_t backing();
+  bool parse_backing(const string &name, backing_t &b);
+  const char *backing_name(backing_t b);
+
+  void *allocate(size_t bytes);
+  void deallocate(void *p, size_t bytes);
+
+  // Counts the dTLB misses from construction on, if the kernel lets us,
+  // and prints them with the mapping and page fault statistics when
+  // destroyed.
+  class Report {
+    ostream &os;
+    counters::Total tlb_misses;
+  public:
+    Report(ostream &os);
+    ~Report();
+  };
+}
+
+// An allocator for containers whose storage should come from pages.
+template<class T>
+struct page_allocator {
+  typedef T value_type;
+
+  page_allocator() {}
+  template<class U> page_allocator(const page_allocator<U> &) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(pages::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, size_t n) {
+    pages::deallocate(p, n * sizeof(T));
+  }
+
+  friend bool operator==(const page_allocator &, const page_allocator &) { return true; }
+  friend bool operator!=(const page_allocator &, const page_allocator &) { return false; }
+};
+
+
+#endif
@@ -0,0 +1,44 @@
+#include "page_alloc.hh"
+#include "count_paths.hh"
+#include "batch.hh"
+#include "sort_reduce.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <sstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+// Every table here is backed by transparent huge pages.  The backing is
+// set once, before main and so before the first allocation.
+const bool backed = (pages::set_backing(pages::transparent), true);
+
+TEST(Pages, mapped_tables) {
+  ASSERT_TRUE(backed);
+  vector<uint32_t, page_allocator<uint32_t> > table(pages::min_bytes);
+  for(size_t i = 0; i < table.size(); ++i) {
+    table[i] = i;
+  }
+  EXPECT_EQ(table.size() - 1, table.back());
+
+  // the sort engine's tables are mapped, whatever the threads
+  EXPECT_EQ(301716, count_paths_sorted<VectorConfig>(parse(hard_grid), 1));
+  EXPECT_EQ(301716, count_paths_sorted<VectorConfig>(parse(hard_grid), 4));
+}
+
+TEST(Pages, node_slabs) {
+  ostringstream report;
+  {
+    pages::Report pages_report(report);
+
+    // hash table nodes come from slabs, on worker threads too; the second
+    // batch reuses the nodes the first one's threads left
+    EXPECT_EQ(301716u, (semiring_paths<CountSemiring<uint64_t>, VectorConfig>(parse(hard_grid))));
+    const vector<Grid> batch(4, parse(hard_grid));
+    EXPECT_EQ(vector<uint64_t>(4, 301716), count_batch<VectorConfig>(batch, 3).counts);
+    EXPECT_EQ(vector<uint64_t>(4, 301716), count_batch<VectorConfig>(batch, 3).counts);
+  }
+  EXPECT_NE(string::npos, report.str().find("pages: thp, ")) << report.str();
+  EXPECT_EQ(string::npos, report.str().find(" 0 of them node slabs")) << report.str();
+}
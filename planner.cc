@@ -0,0 +1,235 @@
+#include "planner.hh"
+
+#include <iomanip>
+#include <sstream>
+#include "dfs.hh"
+#include "symmetry.hh"
+#include "transfer.hh"
+
+double configuration_bound(const vector<bool> &usable, unsigned ends) {
+  // ways[depth][e]: prefixes with depth fragments open and e ends
+  const size_t width = usable.size();
+  vector<vector<double> > ways(width / 2 + 2, vector<double>(ends + 1, 0)), next(ways);
+  ways[0][0] = 1;
+
+  for(auto col : range(width)) {
+    for(auto &depth : next) {
+      fill(begin(depth), end(depth), 0);
+    }
+    for(size_t depth = 0; depth < ways.size(); ++depth) {
+      for(unsigned e = 0; e <= ends; ++e) {
+	const double w = ways[depth][e];
+	if (w == 0)
+	  continue;
+	next[depth][e] += w;                    // unused
+	if (not usable[col])
+	  continue;
+	if (depth + 1 < ways.size())
+	  next[depth + 1][e] += w;              // opens a fragment
+	if (depth > 0)
+	  next[depth - 1][e] += w;              // closes one
+	if (e < ends)
+	  next[depth][e + 1] += w;              // leads to an endpoint
+      }
+    }
+    swap(ways, next);
+  }
+
+  double total = 0;
+  for(auto w : ways[0]) {
+    total += w;
+  }
+  return total;
+}
+
+vector<RowPlan> row_bounds(const Grid &g) {
+  const string cells = g.codes();
+  vector<RowPlan> rows;
+  unsigned ends = 0;
+
+  for(size_t row = 0; row < g.rows; ++row) {
+    vector<bool> usable(g.cols, false);
+    size_t width = 0;
+    for(size_t col = 0; col < g.cols; ++col) {
+      if (cells[row * g.cols + col] == '2' or cells[row * g.cols + col] == '3')
+	++ends;
+      usable[col] = (row + 1 < g.rows and cells[row * g.cols + col] != '1' and
+		     cells[(row + 1) * g.cols + col] != '1');
+      width += usable[col];
+    }
+    rows.push_back(RowPlan({width, configuration_bound(usable, min(ends, 2u)), 0, 0, false, 0}));
+  }
+  return rows;
+}
+
+namespace {
+  // a multiply-add of the transfer matrix products
+  const double matrix_seconds = 1e-9;
+
+  // The mirror engine sweeps the rows it folds, the mirrored rows from the
+  // top and every row below the last unmirrored one, with about half the
+  // states.
+  void plan_mirror(const Grid &g, const EnginePlan &hash, OrientationPlan &plan) {
+    const string codes = g.codes();
+    size_t paired = 0, merge_from = g.rows;
+    while (paired < g.rows and mirrored_row(g, codes, paired))
+      ++paired;
+    while (merge_from > 0 and mirrored_row(g, codes, merge_from - 1))
+      --merge_from;
+    if (paired == 0 and merge_from == g.rows)
+      return;
+
+    double seconds = 0, peak = 1, before = 1;
+    for(size_t row = 0; row < g.rows; ++row) {
+      const RowPlan &r = plan.row_plans[row];
+      const double share = row < paired or row >= merge_from ? 0.5 : 1;
+      seconds += share * r.seconds;
+      peak = max(peak, share * (before + r.states));
+      before = r.states;
+    }
+    plan.engines.push_back(EnginePlan({"mirror", hash.configuration, "--symmetry",
+				       peak, peak * hash.peak_bytes / hash.peak_states, seconds}));
+  }
+
+  // The power engine takes a run of at least min_power_run rows of one
+  // profile, if its states stay within max_power_states, in one sweep for
+  // the matrix and log2 of the run's length matrix products.
+  void plan_power(const Grid &g, const EnginePlan &hash, OrientationPlan &plan) {
+    const string codes = g.codes();
+    double seconds = 0, peak = 1, matrix_bytes = 0, before = 1;
+    bool powered = false;
+    for(size_t row = 0; row < g.rows; ) {
+      const string profile = row_profile(g, codes, row);
+      size_t run = 1;
+      while (row + run < g.rows and row_profile(g, codes, row + run) == profile)
+	++run;
+
+      double most = before;
+      for(size_t i = row; i < row + run; ++i) {
+	most = max(most, plan.row_plans[i].states);
+      }
+      if (run >= min_power_run and most <= max_power_states) {
+	powered = true;
+	seconds += plan.row_plans[row].seconds + log2((double)run) * most * most * most * matrix_seconds;
+	peak = max(peak, most);
+	matrix_bytes = max(matrix_bytes, 2 * most * most * sizeof(uint64_t));
+      } else {
+	for(size_t i = row; i < row + run; ++i) {
+	  seconds += plan.row_plans[i].seconds;
+	  peak = max(peak, (i == row ? before : plan.row_plans[i - 1].states) + plan.row_plans[i].states);
+	}
+      }
+      before = plan.row_plans[row + run - 1].states;
+      row += run;
+    }
+    if (powered) {
+      plan.engines.push_back(EnginePlan({"power", hash.configuration, "--transfer", peak,
+					 peak * hash.peak_bytes / hash.peak_states + matrix_bytes, seconds}));
+    }
+  }
+}
+
+vector<OrientationPlan> plan_grid(const Grid &g, size_t sample_cap) {
+  vector<OrientationPlan> plans;
+  const struct { const char *name; bool transpose, flip; } orientations[] = {
+    {"given", false, false},
+    {"flipped", false, true},
+    {"transposed", true, false},
+    {"transposed-flipped", true, true},
+  };
+
+  for(auto &o : orientations) {
+    const Grid oriented = g.reoriented(o.transpose, o.flip);
+    OrientationPlan plan;
+    plan.name = o.name;
+    plan.transpose = o.transpose;
+    plan.flip = o.flip;
+    plan.rows = oriented.rows;
+    plan.cols = oriented.cols;
+    plan.row_plans = row_bounds(oriented);
+    with_configuration(oriented.cols, SamplePlan{oriented, plan, sample_cap, 1});
+
+    const EnginePlan hash = plan.engines.front();
+    plan_mirror(oriented, hash, plan);
+    plan_power(oriented, hash, plan);
+    if (dfs_fits(oriented)) {
+      // the search keeps a bitboard a level, as deep as there are rooms
+      const DfsEstimate dfs = estimate_dfs(oriented, sample_cap, 1);
+      const double depth = oriented.nodes.size();
+      plan.engines.push_back(EnginePlan({"dfs", "bitboards", "--engine dfs", depth,
+					 depth * 2 * sizeof(uint64_t), dfs.seconds}));
+    }
+    plan.auto_engine = prefer_dfs(oriented) ? "dfs" : "hash";
+    plans.push_back(plan);
+  }
+  return plans;
+}
+
+namespace {
+  string amount(double x) {
+    ostringstream os;
+    if (x < 1e4)
+      os << (long long)(x + 0.5);
+    else
+      os << setprecision(2) << x;
+    return os.str();
+  }
+
+  string bytes(double b) {
+    const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB"};
+    int unit = 0;
+    while (b >= 1024 and unit < 5) {
+      b /= 1024;
+      ++unit;
+    }
+    ostringstream os;
+    os << fixed << setprecision(unit == 0 ? 0 : 1) << b << " " << units[unit];
+    return os.str();
+  }
+
+  string duration(double s) {
+    ostringstream os;
+    if (s < 60)
+      os << fixed << setprecision(s < 1 ? 3 : 1) << s << " s";
+    else if (s < 3600)
+      os << fixed << setprecision(1) << s / 60 << " min";
+    else if (s < 3600 * 48)
+      os << fixed << setprecision(1) << s / 3600 << " h";
+    else
+      os << setprecision(2) << s / 86400 << " days";
+    return os.str();
+  }
+}
+
+void print_plan(ostream &os, const vector<OrientationPlan> &plans) {
+  const OrientationPlan *best_plan = nullptr;
+  const EnginePlan *best = nullptr;
+
+  for(auto &plan : plans) {
+    os << plan.name << ": " << plan.cols << " columns, " << plan.rows << " rows" << endl;
+    os << "  " << left << setw(6) << "row" << setw(8) << "width" << setw(12) << "bound"
+       << setw(12) << "states" << "successors" << endl;
+    for(size_t row = 0; row < plan.row_plans.size(); ++row) {
+      const RowPlan &r = plan.row_plans[row];
+      os << "  " << setw(6) << row << setw(8) << r.width << setw(12) << amount(r.bound)
+	 << setw(12) << ((r.exact ? "" : "~") + amount(r.states)) << amount(r.successors) << endl;
+    }
+    for(auto &engine : plan.engines) {
+      os << "  " << setw(8) << engine.engine << setw(20) << engine.configuration
+	 << "peak " << setw(10) << amount(engine.peak_states)
+	 << setw(12) << bytes(engine.peak_bytes) << duration(engine.seconds) << endl;
+      if (not best or engine.seconds < best->seconds) {
+	best_plan = &plan;
+	best = &engine;
+      }
+    }
+    os << "  without engine options count runs " << plan.auto_engine << endl;
+    os << right;
+  }
+
+  if (best) {
+    os << "recommended: --orientation " << best_plan->name << " " << best->options
+       << " (" << best->engine << ", " << best->configuration << "), about " << duration(best->seconds)
+       << " and " << bytes(best->peak_bytes) << " on one thread" << endl;
+  }
+}
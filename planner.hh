@@ -0,0 +1,176 @@
+#ifndef __PLANNER_HH__
+#define __PLANNER_HH__
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "count_paths.hh"
+#include "sort_reduce.hh"
+using namespace std;
+
+// Predicts what counting a grid will take before doing it.  For every
+// orientation of the grid the planner works out, row by row, the frontier
+// width after obstacles and an upper bound on the configurations it can
+// hold, then runs a sampled sweep: each row expands at most sample_cap of
+// the current states, and the distinct successors of the sample,
+// extrapolated to all of the states, estimate the next row.  The same
+// sample times the hash and the sort aggregation.  The mirror and power
+// engines are predicted from the hash sweep's rows where they apply, and
+// the depth first search, where the grid fits it, by random probes.
+
+struct RowPlan {
+  size_t width;       // columns that can carry a segment into the next row
+  double bound;       // valid configurations of that many columns
+  double states;      // estimated states carried into the next row
+  double successors;  // estimated successors generated in the row
+  bool exact;         // states is a count, not an estimate
+  double seconds;     // estimated time of the row's hash sweep
+};
+
+struct EnginePlan {
+  string engine, configuration;
+  string options;     // what runs the engine on the command line
+  double peak_states, peak_bytes, seconds;
+};
+
+struct OrientationPlan {
+  string name;
+  bool transpose, flip;
+  size_t rows, cols;
+  vector<RowPlan> row_plans;
+  vector<EnginePlan> engines;
+  string auto_engine;  // what count runs without engine options
+};
+
+// configurations of width columns of which only usable ones may be in
+// use, with at most ends of them leading to an endpoint
+double configuration_bound(const vector<bool> &usable, unsigned ends);
+
+vector<RowPlan> row_bounds(const Grid &g);
+
+// The sampled sweep of one orientation, run with the configuration type
+// the counting would use.
+struct SamplePlan {
+  const Grid &g;
+  OrientationPlan &plan;
+  size_t sample_cap;
+  unsigned seed;
+
+  template<class C> bool run() const;
+};
+
+vector<OrientationPlan> plan_grid(const Grid &g, size_t sample_cap);
+
+// the table of predictions and the recommended orientation and engine
+void print_plan(ostream &os, const vector<OrientationPlan> &plans);
+
+template<class C>
+bool SamplePlan::run() const {
+  typedef chrono::steady_clock clock;
+  typedef semiring_layer_t<CountSemiring<unsigned int>, C> table_t;
+
+  // a hash table node: the entry, the next pointer and the cached hash,
+  // rounded up as malloc does, plus its bucket
+  const double hash_bytes = (sizeof(typename table_t::value_type) + 16 + 15) / 16 * 16 + 16;
+  const double sort_bytes = sizeof(KeyCount<unsigned int>);
+
+  mt19937 rng(seed);
+  vector<Grid::Node::degree_t> target_degrees(g.cols, -1);
+  vector<vector<Grid::Node> > next_neighbors(g.cols);
+
+  vector<C> sample{C(vector<int>(g.cols, 0))};
+  double states = 1;
+  bool exact = true;
+  double hash_seconds = 0, sort_seconds = 0;
+  double hash_peak = 1, sort_peak = 1;
+
+  for(auto row : range(g.rows)) {
+    row_setup(g, row, target_degrees, next_neighbors);
+    RowPlan &row_plan = plan.row_plans[row];
+
+    const auto start = clock::now();
+    vector<C> successors;
+    size_t half = 0;  // successors of the first half of the sample
+    for(auto &config : sample) {
+      if (&config - &sample[0] == (ptrdiff_t)(sample.size() / 2))
+	half = successors.size();
+      for_each_next_config<C>(row, config, target_degrees, next_neighbors,
+        [&](const C &next_config) { successors.push_back(next_config); });
+    }
+    const auto expanded = clock::now();
+
+    table_t table;
+    for(auto &config : successors) {
+      ++table[config].value;
+    }
+    const auto hashed = clock::now();
+
+    if (g.cols <= max_packed_cols) {
+      frontier_table_t<unsigned int> keys, scratch;
+      for(auto &config : successors) {
+	keys.push_back(KeyCount<unsigned int>({pack_configuration(config), 1}));
+      }
+      radix_sort(keys, scratch);
+      reduce_sorted(keys);
+    }
+    const auto sorted = clock::now();
+
+    // once no state is left, neither are the rows' time and successors
+    const double scale = sample.empty() ? 0 : states / sample.size();
+    const double expand_time = chrono::duration<double>(expanded - start).count();
+    row_plan.seconds = scale * (expand_time + chrono::duration<double>(hashed - expanded).count());
+    hash_seconds += row_plan.seconds;
+    sort_seconds += scale * (expand_time + chrono::duration<double>(sorted - hashed).count());
+
+    // Successors of different states merge more the more states there
+    // are, so the distinct successors of the sample are extrapolated by
+    // how they grew from half the sample to all of it: d(n) ~ n^a.
+    double distinct = table.size();
+    if (states > sample.size() and half > 0) {
+      table_t half_table;
+      for(size_t i = 0; i < half; ++i) {
+	++half_table[successors[i]].value;
+      }
+      const double a = max(0.0, min(1.0, log2((double)table.size() / half_table.size())));
+      distinct *= pow(states / sample.size(), a);
+    }
+
+    row_plan.successors = scale * successors.size();
+    row_plan.states = min(distinct, row_plan.bound);
+    row_plan.exact = exact;
+
+    hash_peak = max(hash_peak, states + row_plan.states);
+    sort_peak = max(sort_peak, states + 2 * row_plan.successors);
+
+    states = row_plan.states;
+    vector<const C *> next;
+    for(auto &entry : table) {
+      next.push_back(&entry.first);
+    }
+    if (next.size() > sample_cap) {
+      shuffle(begin(next), end(next), rng);
+      next.resize(sample_cap);
+      exact = false;
+    }
+    vector<C> next_sample;
+    for(auto config : next) {
+      next_sample.push_back(*config);
+    }
+    swap(sample, next_sample);
+  }
+
+  plan.engines.push_back(EnginePlan({"hash", configuration_name(g.cols), "--engine dp",
+				     hash_peak, hash_peak * hash_bytes, hash_seconds}));
+  if (g.cols <= max_packed_cols) {
+    plan.engines.push_back(EnginePlan({"sort", configuration_name(g.cols), "--aggregate sort",
+				       sort_peak, sort_peak * sort_bytes, sort_seconds}));
+  }
+  return true;
+}
+
+
+#endif
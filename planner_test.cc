@@ -0,0 +1,121 @@
+#include "planner.hh"
+#include "dfs.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <sstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+// strings over unused, open, close and end that balance
+double brute_force_bound(size_t width, unsigned ends) {
+  double total = 0;
+  size_t combinations = 1;
+  for(size_t i = 0; i < width; ++i) {
+    combinations *= 4;
+  }
+  for(size_t code = 0; code < combinations; ++code) {
+    int depth = 0;
+    unsigned e = 0;
+    bool ok = true;
+    for(size_t i = 0, c = code; i < width; ++i, c /= 4) {
+      switch(c % 4) {
+      case 1: ++depth; break;
+      case 2: ok = ok and depth-- > 0; break;
+      case 3: ++e; break;
+      }
+    }
+    total += ok and depth == 0 and e <= ends;
+  }
+  return total;
+}
+
+TEST(Planner, configuration_bound) {
+  for(size_t width = 0; width <= 7; ++width) {
+    for(unsigned ends = 0; ends <= 2; ++ends) {
+      EXPECT_EQ(brute_force_bound(width, ends), configuration_bound(vector<bool>(width, true), ends))
+	<< width << " " << ends;
+    }
+  }
+  // columns that are not usable stay unused
+  EXPECT_EQ(configuration_bound(vector<bool>(2, true), 1),
+	    configuration_bound(vector<bool>{true, false, true, false}, 1));
+}
+
+TEST(Planner, reoriented_grids_count_alike) {
+  Grid g = parse("5 5  2 0 0 0 0  0 1 0 0 0  0 0 0 1 0  0 0 0 0 0  1 0 0 0 3");
+  const int expected = count_paths<VectorConfig>(g);
+  for(bool transpose : {false, true}) {
+    for(bool flip : {false, true}) {
+      Grid o = g.reoriented(transpose, flip);
+      EXPECT_EQ(transpose ? g.cols : g.rows, o.rows);
+      EXPECT_EQ(expected, count_paths<VectorConfig>(o)) << transpose << flip;
+    }
+  }
+  EXPECT_EQ(g.codes(), g.reoriented(true, false).reoriented(true, false).codes());
+
+  // not square, and with cells that are not ours
+  const Grid hard = parse(hard_grid);
+  EXPECT_EQ(hard.codes(), hard.reoriented(false, true).reoriented(false, true).codes());
+  EXPECT_EQ(301716, count_paths<VectorConfig>(hard.reoriented(true, true)));
+}
+
+TEST(Planner, small_grids_are_planned_exactly) {
+  Grid g = parse("5 4  2 0 0 0 0  0 0 0 0 0  0 0 0 0 0  3 0 0 0 0");
+  const vector<OrientationPlan> plans = plan_grid(g, 1000000);
+  ASSERT_EQ(4u, plans.size());
+
+  for(auto &plan : plans) {
+    for(auto &row : plan.row_plans) {
+      EXPECT_TRUE(row.exact);
+      EXPECT_LE(row.states, row.bound);
+    }
+    EXPECT_EQ(1, plan.row_plans.back().states);
+    ASSERT_LE(2u, plan.engines.size());
+    EXPECT_EQ("hash", plan.engines[0].engine);
+    EXPECT_EQ("sort", plan.engines[1].engine);
+  }
+}
+
+const EnginePlan *find_engine(const OrientationPlan &plan, const string &engine) {
+  for(auto &e : plan.engines) {
+    if (e.engine == engine)
+      return &e;
+  }
+  return nullptr;
+}
+
+TEST(Planner, engines_where_they_apply) {
+  // few free rooms: count runs the depth first search on its own, and the
+  // plan says so
+  Grid sparse = parse("5 5  2 0 0 0 0  0 0 0 0 0  0 0 0 0 0  0 0 0 0 0  0 0 0 0 3");
+  ASSERT_TRUE(prefer_dfs(sparse));
+  for(auto &plan : plan_grid(sparse, 1000)) {
+    EXPECT_EQ("dfs", plan.auto_engine);
+    const EnginePlan *dfs = find_engine(plan, "dfs");
+    ASSERT_TRUE(dfs);
+    EXPECT_EQ("--engine dfs", dfs->options);
+    EXPECT_LT(0, dfs->seconds);
+  }
+  ostringstream os;
+  print_plan(os, plan_grid(sparse, 1000));
+  EXPECT_NE(string::npos, os.str().find("without engine options count runs dfs")) << os.str();
+
+  // mirrored rows fold, and a run of one profile is powered
+  Grid open = parse("6 8  0 0 0 0 0 0  0 0 0 0 0 0  0 0 0 0 0 0  0 0 0 0 0 0"
+		    "  0 0 0 0 0 0  0 0 0 0 0 0  0 0 0 0 0 0  2 0 0 0 0 3");
+  const OrientationPlan natural = plan_grid(open, 1000).front();
+  EXPECT_EQ("hash", natural.auto_engine);
+  ASSERT_TRUE(find_engine(natural, "mirror"));
+  EXPECT_LT(find_engine(natural, "mirror")->seconds, find_engine(natural, "hash")->seconds);
+  ASSERT_TRUE(find_engine(natural, "power"));
+  EXPECT_EQ("--transfer", find_engine(natural, "power")->options);
+
+  // the hard grid's natural orientation has no mirrored row; a grid
+  // whose states run out has a time, not nan
+  const OrientationPlan hard = plan_grid(parse(hard_grid), 1000).front();
+  EXPECT_FALSE(find_engine(hard, "mirror"));
+  const OrientationPlan blocked = plan_grid(parse("3 3  2 1 0  1 0 0  0 0 3"), 1000).front();
+  EXPECT_GT(1, find_engine(blocked, "hash")->seconds);
+}
@@ -0,0 +1,218 @@
+#include "result_cache.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+string canonical_form(const Grid &g) {
+  const string codes = g.codes();
+
+  string best;
+  for(int transform = 0; transform < 8; ++transform) {
+    const bool transpose = transform & 4, flip_rows = transform & 1, flip_cols = transform & 2;
+    const size_t rows = transpose ? g.cols : g.rows, cols = transpose ? g.rows : g.cols;
+
+    for(bool swap_ends : {false, true}) {
+      string form = to_string(cols) + " " + to_string(rows) + ":";
+      for(size_t row = 0; row < rows; ++row) {
+	for(size_t col = 0; col < cols; ++col) {
+	  size_t r = flip_rows ? rows - 1 - row : row, c = flip_cols ? cols - 1 - col : col;
+	  if (transpose)
+	    swap(r, c);
+	  char code = codes[r * g.cols + c];
+	  if (swap_ends and (code == '2' or code == '3'))
+	    code = code == '2' ? '3' : '2';
+	  form += code;
+	}
+      }
+      if (best.empty() or form < best)
+	best = form;
+    }
+  }
+  return best;
+}
+
+namespace {
+  const char magic[4] = {'H', 'R', 'E', 'S'};
+  const uint32_t format_version = 1;
+  const uint64_t initial_capacity = 1024;
+
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t capacity;  // slots, a power of two
+    uint64_t used;
+  };
+
+  struct Slot {
+    uint64_t h1, h2;  // both zero: empty
+    int64_t value;
+  };
+
+  uint64_t hash64(const string &s, uint64_t seed) {
+    uint64_t h = 0xcbf29ce484222325ull ^ seed;
+    for(unsigned char c : s) {
+      h = (h ^ c) * 0x100000001b3ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  size_t file_size(uint64_t capacity) {
+    return sizeof(Header) + capacity * sizeof(Slot);
+  }
+
+  // The mapped cache file, locked for as long as it is open.
+  class Table {
+    int fd;
+    size_t length;
+    void *base;
+
+  public:
+    Table(const string &path, bool write) :
+      fd(open(path.c_str(), write ? O_RDWR | O_CREAT : O_RDONLY, 0644)),
+      length(0),
+      base(MAP_FAILED)
+    {
+      if (fd < 0)
+	return;
+      flock(fd, write ? LOCK_EX : LOCK_SH);
+
+      struct stat st;
+      if (fstat(fd, &st) != 0)
+	return;
+      if (st.st_size == 0 and write) {
+	if (ftruncate(fd, file_size(initial_capacity)) != 0)
+	  return;
+	st.st_size = file_size(initial_capacity);
+	map(st.st_size, write);
+	if (ok()) {
+	  Header &h = header();
+	  memcpy(h.magic, magic, sizeof(magic));
+	  h.version = format_version;
+	  h.capacity = initial_capacity;
+	  h.used = 0;
+	}
+	return;
+      }
+      if ((size_t)st.st_size < sizeof(Header))
+	return;
+
+      map(st.st_size, write);
+      if (ok() and (memcmp(header().magic, magic, sizeof(magic)) != 0 or
+		    header().version != format_version or
+		    header().capacity == 0 or (header().capacity & (header().capacity - 1)) != 0 or
+		    file_size(header().capacity) != length))
+	unmap();
+    }
+
+    ~Table() {
+      unmap();
+      if (fd >= 0)
+	close(fd);
+    }
+
+    bool ok() const { return base != MAP_FAILED; }
+    Header &header() { return *static_cast<Header *>(base); }
+    Slot *slots() { return reinterpret_cast<Slot *>(static_cast<Header *>(base) + 1); }
+
+    void map(size_t size, bool write) {
+      length = size;
+      base = mmap(nullptr, length, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    }
+
+    void unmap() {
+      if (ok())
+	munmap(base, length);
+      base = MAP_FAILED;
+    }
+
+    // the slot holding (h1, h2), or the empty one where it would go
+    Slot &find(uint64_t h1, uint64_t h2) {
+      const uint64_t mask = header().capacity - 1;
+      for(uint64_t i = h1 & mask; ; i = (i + 1) & mask) {
+	Slot &slot = slots()[i];
+	if ((slot.h1 == h1 and slot.h2 == h2) or (slot.h1 == 0 and slot.h2 == 0))
+	  return slot;
+      }
+    }
+
+    // doubles the table, rehashing every entry
+    bool grow() {
+      const uint64_t capacity = header().capacity;
+      vector<Slot> entries;
+      for(uint64_t i = 0; i < capacity; ++i) {
+	if (slots()[i].h1 != 0 or slots()[i].h2 != 0)
+	  entries.push_back(slots()[i]);
+      }
+
+      unmap();
+      if (ftruncate(fd, file_size(2 * capacity)) != 0)
+	return false;
+      map(file_size(2 * capacity), true);
+      if (not ok())
+	return false;
+
+      header().capacity = 2 * capacity;
+      memset(slots(), 0, 2 * capacity * sizeof(Slot));
+      for(auto &entry : entries) {
+	find(entry.h1, entry.h2) = entry;
+      }
+      return true;
+    }
+  };
+
+  void key_hashes(const string &key, uint64_t &h1, uint64_t &h2) {
+    h1 = hash64(key, 0);
+    h2 = hash64(key, 0x9e3779b97f4a7c15ull);
+    if (h1 == 0 and h2 == 0)
+      h1 = 1;
+  }
+}
+
+ResultCache::ResultCache(const string &directory) :
+  path(directory + "/results")
+{
+  mkdir(directory.c_str(), 0755);
+}
+
+bool ResultCache::lookup(const string &key, int64_t &value) const {
+  Table table(path, false);
+  if (not table.ok())
+    return false;
+
+  uint64_t h1, h2;
+  key_hashes(key, h1, h2);
+  const Slot &slot = table.find(h1, h2);
+  if (slot.h1 != h1 or slot.h2 != h2)
+    return false;
+
+  value = slot.value;
+  return true;
+}
+
+bool ResultCache::store(const string &key, int64_t value) {
+  Table table(path, true);
+  if (not table.ok())
+    return false;
+
+  uint64_t h1, h2;
+  key_hashes(key, h1, h2);
+  if (2 * (table.header().used + 1) > table.header().capacity and not table.grow())
+    return false;
+
+  Slot &slot = table.find(h1, h2);
+  if (slot.h1 != h1 or slot.h2 != h2)
+    ++table.header().used;
+  slot.h1 = h1;
+  slot.h2 = h2;
+  slot.value = value;
+  return true;
+}
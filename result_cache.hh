@@ -0,0 +1,35 @@
+#ifndef __RESULT_CACHE_HH__
+#define __RESULT_CACHE_HH__
+
+#include <string>
+#include <stdint.h>
+#include "grid.hh"
+using namespace std;
+
+// The canonical form of a grid's layout of rooms, blocked cells, intake
+// and AC under the symmetries that keep its number of paths: the eight
+// rotations and reflections, each with and without the intake and the AC
+// swapped.  It is the smallest of the sixteen encodings, so grids that are
+// symmetric images of each other share it.
+string canonical_form(const Grid &g);
+
+// Path counts on disk, keyed by canonical form.  The cache is a single
+// file in the directory, an open addressing hash table that is mapped for
+// every lookup and store.  Readers share an flock and writers take it
+// exclusively, so any number of processes can use one cache at once.  A
+// key is stored as two independent 64 bit hashes of the canonical form.
+class ResultCache {
+  string path;
+
+public:
+  // creates the directory if it is missing
+  ResultCache(const string &directory);
+
+  bool lookup(const string &key, int64_t &value) const;
+
+  // false if the cache could not be written
+  bool store(const string &key, int64_t value);
+};
+
+
+#endif
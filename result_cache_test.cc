@@ -0,0 +1,87 @@
+#include "result_cache.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <unistd.h>
+using namespace std;
+
+string canonical(const string &text) {
+  return canonical_form(parse(text));
+}
+
+string temporary_directory() {
+  char name[] = "/tmp/result_cache_test.XXXXXX";
+  return mkdtemp(name);
+}
+
+TEST(CanonicalForm, symmetric_images_agree) {
+  const string grid = "4 3  2 0 0 0  0 0 0 0  0 0 3 1";
+  const string form = canonical(grid);
+
+  EXPECT_EQ(form, canonical("3 4  2 0 0  0 0 0  0 0 3  0 0 1"));   // transposed
+  EXPECT_EQ(form, canonical("4 3  0 0 0 2  0 0 0 0  1 3 0 0"));    // mirrored
+  EXPECT_EQ(form, canonical("4 3  1 3 0 0  0 0 0 0  0 0 0 2"));    // rotated half a turn
+  EXPECT_EQ(form, canonical("4 3  3 0 0 0  0 0 0 0  0 0 2 1"));    // ends swapped
+
+  EXPECT_NE(form, canonical("4 3  2 0 0 0  0 0 0 0  0 3 0 1"));
+  EXPECT_NE(form, canonical("4 3  2 0 0 0  0 1 0 0  0 0 3 1"));
+}
+
+TEST(ResultCache, store_and_lookup) {
+  const string directory = temporary_directory();
+  ResultCache cache(directory);
+  int64_t value = 0;
+
+  EXPECT_FALSE(cache.lookup("a", value));
+  EXPECT_TRUE(cache.store("a", 42));
+  EXPECT_TRUE(cache.lookup("a", value));
+  EXPECT_EQ(42, value);
+  EXPECT_TRUE(cache.store("a", -7));
+  EXPECT_TRUE(ResultCache(directory).lookup("a", value));
+  EXPECT_EQ(-7, value);
+
+  // past the initial capacity
+  for(int i = 0; i < 3000; ++i) {
+    ASSERT_TRUE(cache.store("key " + to_string(i), i));
+  }
+  for(int i = 0; i < 3000; ++i) {
+    ASSERT_TRUE(cache.lookup("key " + to_string(i), value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(cache.lookup("key 3000", value));
+
+  unlink((directory + "/results").c_str());
+  rmdir(directory.c_str());
+}
+
+TEST(ResultCache, concurrent_writers) {
+  const string directory = temporary_directory();
+  vector<thread> writers;
+  for(int w = 0; w < 4; ++w) {
+    writers.emplace_back([=] {
+	ResultCache cache(directory);
+	for(int i = 0; i < 500; ++i) {
+	  cache.store(to_string(w) + " " + to_string(i), w * 1000 + i);
+	}
+      });
+  }
+  for(auto &writer : writers) {
+    writer.join();
+  }
+
+  ResultCache cache(directory);
+  for(int w = 0; w < 4; ++w) {
+    for(int i = 0; i < 500; ++i) {
+      int64_t value = 0;
+      ASSERT_TRUE(cache.lookup(to_string(w) + " " + to_string(i), value));
+      EXPECT_EQ(w * 1000 + i, value);
+    }
+  }
+
+  unlink((directory + "/results").c_str());
+  rmdir(directory.c_str());
+}
@@ -0,0 +1,67 @@
+#ifndef __SEMIRING_HH__
+#define __SEMIRING_HH__
+
+#include <algorithm>
+#include <limits>
+#include "costs.hh"
+using namespace std;
+
+// The semirings the row sweep can run over.  plus combines the layouts
+// that reach the same state, times extends a layout by one row and
+// weight turns that row's cost into an element.  Semirings that are not
+// weighted ignore costs, and the sweep does not compute them.
+
+// number of layouts
+template<class T>
+struct CountSemiring {
+  typedef T value_type;
+  static const bool weighted = false;
+  static const char *name() { return "count"; }
+
+  static T zero() { return 0; }
+  static T one() { return 1; }
+  static T plus(T a, T b) { return a + b; }
+  static T times(T a, T b) { return a * b; }
+  static T weight(cost_t) { return 1; }
+};
+
+// cost of the cheapest layout; zero() (no layout) is the largest cost
+struct MinCostSemiring {
+  typedef cost_t value_type;
+  static const bool weighted = true;
+  static const char *name() { return "min"; }
+
+  static cost_t zero() { return numeric_limits<cost_t>::max(); }
+  static cost_t one() { return 0; }
+  static cost_t plus(cost_t a, cost_t b) { return min(a, b); }
+  static cost_t times(cost_t a, cost_t b) {
+    return a == zero() or b == zero() ? zero() : a + b;
+  }
+  static cost_t weight(cost_t cost) { return cost; }
+};
+
+// cost of the dearest layout; zero() (no layout) is the smallest cost
+struct MaxCostSemiring {
+  typedef cost_t value_type;
+  static const bool weighted = true;
+  static const char *name() { return "max"; }
+
+  static cost_t zero() { return numeric_limits<cost_t>::min(); }
+  static cost_t one() { return 0; }
+  static cost_t plus(cost_t a, cost_t b) { return max(a, b); }
+  static cost_t times(cost_t a, cost_t b) {
+    return a == zero() or b == zero() ? zero() : a + b;
+  }
+  static cost_t weight(cost_t cost) { return cost; }
+};
+
+// A semiring element that starts out as zero(), so a fresh hash table
+// slot is ready to be plus-ed into.
+template<class S>
+struct semiring_value {
+  typename S::value_type value;
+  semiring_value() : value(S::zero()) {}
+};
+
+
+#endif
@@ -0,0 +1,182 @@
+#include "count_paths.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <sstream>
+#include <vector>
+#include <string>
+#include <random>
+using namespace std;
+
+const vector<string> grids {
+  "4 3  2 0 0 0  0 0 0 0  0 0 3 1",
+  "5 4  2 0 0 0 0  0 0 0 0 0  0 0 0 0 0  3 0 0 0 0",
+  "5 5  2 0 0 0 0  0 1 0 0 0  0 0 0 1 0  0 0 0 0 0  1 0 0 0 3",
+  "3 3  2 1 0  1 0 0  0 0 3",
+};
+
+CostGrid random_costs(const Grid &g, mt19937 &rng) {
+  uniform_int_distribution<int> cost(0, 9);
+  CostGrid costs(g.rows, g.cols);
+  for(auto v : {&costs.cell, &costs.right, &costs.down}) {
+    for(auto &c : *v) {
+      c = cost(rng);
+    }
+  }
+  return costs;
+}
+
+// the cost of a layout, checking it is one on the way
+cost_t layout_cost(Grid g, const CostGrid &costs, const vector<segment_t> &layout) {
+  vector<int> degree(g.rows * g.cols, 0);
+  cost_t total = 0;
+  for(auto &segment : layout) {
+    EXPECT_TRUE(g.connected(segment.first, segment.second));
+    ++degree[g.index(segment.first)];
+    ++degree[g.index(segment.second)];
+    total += (segment.first.first == segment.second.first ?
+	      costs.right_cost(segment.first.first, segment.first.second) :
+	      costs.down_cost(segment.first.first, segment.first.second));
+  }
+  for(auto row : range(g.rows)) {
+    for(auto col : range(g.cols)) {
+      EXPECT_EQ(max<int>(g.target_degree(row, col), 0), degree[g.index(row, col)]);
+      if (g.target_degree(row, col) > 0)
+	total += costs.cell_cost(row, col);
+    }
+  }
+  return total;
+}
+
+TEST(Semiring, count_and_exists_agree) {
+  for(auto text : grids) {
+    Grid g = parse(text);
+    const int count = count_paths<VectorConfig>(g);
+    EXPECT_EQ((unsigned)count, (semiring_paths<CountSemiring<unsigned>, VectorConfig>(g))) << text;
+    EXPECT_EQ(count > 0, paths_exist<VectorConfig>(g)) << text;
+  }
+}
+
+TEST(Semiring, two_layouts) {
+  // test.quora has two layouts; only one of them uses the first segment
+  Grid g = parse(grids[0]);
+  CostGrid costs(g.rows, g.cols);
+  costs.right[0] = 5;
+
+  EXPECT_EQ(0, (semiring_paths<MinCostSemiring, VectorConfig>(g, &costs)));
+  EXPECT_EQ(5, (semiring_paths<MaxCostSemiring, VectorConfig>(g, &costs)));
+}
+
+TEST(Semiring, reconstructed_layouts_attain_the_optimum) {
+  mt19937 rng(7);
+  for(auto text : grids) {
+    Grid g = parse(text);
+    const bool any = count_paths<VectorConfig>(g) > 0;
+    for(int i = 0; i < 5; ++i) {
+      const CostGrid costs = random_costs(g, rng);
+
+      vector<semiring_layer_t<MinCostSemiring, VectorConfig> > min_layers;
+      const cost_t min_cost = semiring_paths<MinCostSemiring, VectorConfig>(g, &costs, &min_layers);
+      const auto min_layout = reconstruct_layout<MinCostSemiring, VectorConfig>(g, costs, min_layers);
+
+      vector<semiring_layer_t<MaxCostSemiring, VectorConfig> > max_layers;
+      const cost_t max_cost = semiring_paths<MaxCostSemiring, VectorConfig>(g, &costs, &max_layers);
+      const auto max_layout = reconstruct_layout<MaxCostSemiring, VectorConfig>(g, costs, max_layers);
+
+      ASSERT_EQ(any, not min_layout.empty()) << text;
+      ASSERT_EQ(any, not max_layout.empty()) << text;
+      if (not any)
+	continue;
+
+      EXPECT_LE(min_cost, max_cost);
+      EXPECT_EQ(min_cost, layout_cost(g, costs, min_layout)) << text;
+      EXPECT_EQ(max_cost, layout_cost(g, costs, max_layout)) << text;
+    }
+  }
+}
+
+TEST(Semiring, counted_sweeps_agree) {
+  // counters on: the states go through the batched expand and aggregate
+  mt19937 rng(43);
+  vector<pair<cost_t, unsigned> > expected;
+  for(auto text : grids) {
+    Grid g = parse(text);
+    const CostGrid costs = random_costs(g, rng);
+    expected.push_back(make_pair(semiring_paths<MinCostSemiring, VectorConfig>(g, &costs),
+				 semiring_paths<CountSemiring<unsigned>, VectorConfig>(g)));
+  }
+  const Grid hard = parse(hard_grid);
+
+  counters::start();
+  rng.seed(43);
+  for(size_t i = 0; i < grids.size(); ++i) {
+    Grid g = parse(grids[i]);
+    const CostGrid costs = random_costs(g, rng);
+    EXPECT_EQ(expected[i].first, (semiring_paths<MinCostSemiring, VectorConfig>(g, &costs))) << grids[i];
+    EXPECT_EQ(expected[i].second, (semiring_paths<CountSemiring<unsigned>, VectorConfig>(g))) << grids[i];
+  }
+  EXPECT_EQ(301716, count_paths<VectorConfig>(hard));  // batches of more than one
+  counters::enabled = false;
+
+  ostringstream report;
+  counters::report(report);
+  EXPECT_NE(string::npos, report.str().find("counters: expand"));
+}
+
+TEST(CostGrid, parse) {
+  istringstream cells("3 2  1 2 3  4 5 6");
+  CostGrid c(cells, 2, 3);
+  ASSERT_TRUE(c.valid);
+  EXPECT_EQ(6, c.cell_cost(1, 2));
+  EXPECT_EQ(0, c.right_cost(0, 0));
+
+  istringstream segments("3 2  1 2 3  4 5 6  7 8  9 10  11 12 13");
+  CostGrid s(segments, 2, 3);
+  ASSERT_TRUE(s.valid);
+  EXPECT_EQ(8, s.right_cost(0, 1));
+  EXPECT_EQ(10, s.right_cost(1, 1));
+  EXPECT_EQ(13, s.down_cost(0, 2));
+
+  istringstream short_cells("3 2  1 2 3  4 5");
+  EXPECT_FALSE(CostGrid(short_cells, 2, 3).valid);
+
+  istringstream short_segments("3 2  1 2 3  4 5 6  7 8  9 10  11 12");
+  EXPECT_FALSE(CostGrid(short_segments, 2, 3).valid);
+
+  // sizes other than the grid's are refused before anything is allocated
+  istringstream huge("5000000000 1  1");
+  EXPECT_FALSE(CostGrid(huge, 2, 3).valid);
+  istringstream transposed("2 3  1 2  3 4  5 6");
+  EXPECT_FALSE(CostGrid(transposed, 2, 3).valid);
+  istringstream empty("0 0");
+  EXPECT_FALSE(CostGrid(empty, 0, 0).valid);
+}
+
+TEST(SweepControl, snapshot_and_resume) {
+  typedef CountSemiring<unsigned> S;
+  const string file = "/tmp/semiring_test.snapshot";
+  Grid g = parse(grids[1]);
+
+  SweepLimits limits;
+  limits.time_limit = 1e-9;
+  limits.snapshot_file = file;
+  SweepControl stopping(limits, g.rows);
+  semiring_paths<S, VectorConfig>(g, nullptr, nullptr, &stopping);
+  ASSERT_TRUE(stopping.stopped());
+  EXPECT_EQ("time limit", stopping.reason());
+
+  SweepLimits resume;
+  resume.resume_file = file;
+  SweepControl resuming(resume, g.rows);
+  EXPECT_EQ((unsigned)count_paths<VectorConfig>(g),
+	    (semiring_paths<S, VectorConfig>(g, nullptr, nullptr, &resuming)));
+  EXPECT_FALSE(resuming.stopped());
+
+  // not a snapshot of this grid
+  Grid other = parse(grids[0]);
+  SweepControl refusing(resume, other.rows);
+  semiring_paths<S, VectorConfig>(other, nullptr, nullptr, &refusing);
+  EXPECT_TRUE(refusing.stopped());
+
+  remove(file.c_str());
+}
@@ -0,0 +1,161 @@
+#include "sharded.hh"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct ShardSegment::Header {
+  atomic<uint64_t> sent;        // done_sending calls so far, n a row
+  alignas(64) atomic<uint32_t> arrived;
+  atomic<uint32_t> generation;  // barriers passed
+};
+
+namespace {
+  size_t round_up(size_t bytes, size_t to) { return (bytes + to - 1) / to * to; }
+
+  size_t power_of_two(size_t at_least) {
+    size_t p = 1;
+    while (p < at_least) {
+      p *= 2;
+    }
+    return p;
+  }
+}
+
+ShardSegment::ShardSegment(unsigned workers, size_t ring_entries) :
+  n(workers),
+  capacity(power_of_two(max<size_t>(ring_entries, 1))),
+  ring_bytes(round_up(sizeof(Ring) + capacity * sizeof(Entry), 64)),
+  rings_offset(round_up(sizeof(Header), 64) + round_up(n * sizeof(uint64_t), 64)),
+  length(rings_offset + (size_t)n * n * ring_bytes),
+  base(nullptr)
+{
+  static atomic<unsigned> segments(0);
+  const string name = "/count_paths." + to_string(getpid()) + "." + to_string(segments++);
+
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    cerr << "Couldn't create shared memory '" << name << "': " << strerror(errno) << endl;
+    return;
+  }
+  // the workers are forked with the mapping, so the name is not needed
+  // past this point, and cannot be left behind
+  shm_unlink(name.c_str());
+
+  void *p = MAP_FAILED;
+  if (ftruncate(fd, length) == 0)
+    p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    cerr << "Couldn't map " << length << " bytes of shared memory: " << strerror(errno) << endl;
+    return;
+  }
+
+  base = (uint8_t *)p;
+  new (&header()) Header();
+  header().sent = 0;
+  header().arrived = 0;
+  header().generation = 0;
+  for(unsigned from = 0; from < n; ++from) {
+    for(unsigned to = 0; to < n; ++to) {
+      ring(from, to).head = 0;
+      ring(from, to).tail = 0;
+    }
+  }
+}
+
+ShardSegment::~ShardSegment() {
+  if (base)
+    munmap(base, length);
+}
+
+void ShardSegment::done_sending() const {
+  header().sent.fetch_add(1, memory_order_release);
+}
+
+bool ShardSegment::all_sent(size_t row) const {
+  return header().sent.load(memory_order_acquire) >= (uint64_t)n * (row + 1);
+}
+
+void ShardSegment::barrier() const {
+  Header &h = header();
+  const uint32_t generation = h.generation.load(memory_order_acquire);
+  if (h.arrived.fetch_add(1, memory_order_acq_rel) + 1 == n) {
+    h.arrived.store(0, memory_order_relaxed);
+    h.generation.fetch_add(1, memory_order_release);
+    return;
+  }
+  while (h.generation.load(memory_order_acquire) == generation) {
+    sched_yield();
+  }
+}
+
+bool ShardSegment::run(const function<uint64_t (unsigned)> &worker, uint64_t &total) const {
+  uint64_t *totals = (uint64_t *)(base + round_up(sizeof(Header), 64));
+  vector<pid_t> pids;
+
+  bool ok = true;
+  for(unsigned me = 0; me < n; ++me) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      totals[me] = worker(me);
+      _exit(0);
+    }
+    if (pid < 0) {
+      cerr << "Couldn't start worker " << me << ": " << strerror(errno) << endl;
+      ok = false;
+      break;
+    }
+    pids.push_back(pid);
+  }
+
+  // the others would wait for a failed worker forever
+  if (not ok) {
+    for(auto pid : pids) {
+      kill(pid, SIGKILL);
+    }
+  }
+  // Each worker is waited for by its pid, so the caller's other children
+  // and their exit statuses are left alone.  They are polled rather than
+  // waited for in turn, as a worker that fails has to be noticed while the
+  // others wait for it.
+  vector<bool> reaped(pids.size(), false);
+  size_t running = pids.size();
+  while (running > 0) {
+    bool any = false;
+    for(size_t i = 0; i < pids.size(); ++i) {
+      if (reaped[i])
+	continue;
+      int status;
+      const pid_t pid = waitpid(pids[i], &status, WNOHANG);
+      if (pid == 0 or (pid < 0 and errno == EINTR))
+	continue;
+      reaped[i] = true;
+      --running;
+      any = true;
+      if (ok and (pid < 0 or not (WIFEXITED(status) and WEXITSTATUS(status) == 0))) {
+	cerr << "A worker process failed" << endl;
+	ok = false;
+	for(auto other : pids) {
+	  kill(other, SIGKILL);
+	}
+      }
+    }
+    if (not any and running > 0)
+      usleep(1000);
+  }
+
+  total = 0;
+  for(unsigned me = 0; ok and me < n; ++me) {
+    total += totals[me];
+  }
+  return ok;
+}
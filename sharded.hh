@@ -0,0 +1,179 @@
+#ifndef __SHARDED_HH__
+#define __SHARDED_HH__
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include <sched.h>
+
+#include "count_paths.hh"
+#include "packed.hh"
+using namespace std;
+
+// The row sweep split across worker processes.  Every state belongs to
+// the worker its packed key hashes to.  A worker expands the states it
+// owns and sends each successor to its owner through a ring buffer in a
+// shared memory segment, one ring per pair of workers; successors it owns
+// itself go straight into its own table.  When every worker is done
+// sending and has drained its rings, a barrier ends the row.  The count
+// is the sum of the workers' totals after the last row.
+//
+// The segment comes from shm_open and the workers are forked, so they can
+// be moved to cgroups of their own once running.
+class ShardSegment {
+public:
+  struct Entry {
+    packed_config_t key;
+    uint64_t count;
+  };
+
+  // single producer, single consumer; head and tail only grow
+  struct Ring {
+    alignas(64) atomic<uint64_t> head;
+    alignas(64) atomic<uint64_t> tail;
+  };
+
+private:
+  struct Header;
+
+  const unsigned n;
+  const size_t capacity;  // entries per ring, a power of two
+  const size_t ring_bytes;
+  const size_t rings_offset;  // after the header and the workers' totals
+  size_t length;
+  uint8_t *base;
+
+  Header &header() const { return *(Header *)base; }
+
+public:
+  ShardSegment(unsigned workers, size_t ring_entries);
+  ~ShardSegment();
+
+  // false if the segment could not be made
+  bool ok() const { return base != nullptr; }
+  unsigned workers() const { return n; }
+
+  Ring &ring(unsigned from, unsigned to) const {
+    return *(Ring *)(base + rings_offset + (from * n + to) * ring_bytes);
+  }
+  Entry *entries(const Ring &r) const { return (Entry *)((uint8_t *)&r + sizeof(Ring)); }
+
+  bool try_push(Ring &r, const Entry &entry) const {
+    const uint64_t tail = r.tail.load(memory_order_relaxed);
+    if (tail - r.head.load(memory_order_acquire) == capacity)
+      return false;
+    entries(r)[tail & (capacity - 1)] = entry;
+    r.tail.store(tail + 1, memory_order_release);
+    return true;
+  }
+
+  template<class F>
+  void drain(Ring &r, F action) const {
+    const uint64_t head = r.head.load(memory_order_relaxed);
+    const uint64_t tail = r.tail.load(memory_order_acquire);
+    for(uint64_t i = head; i != tail; ++i) {
+      action(entries(r)[i & (capacity - 1)]);
+    }
+    r.head.store(tail, memory_order_release);
+  }
+
+  // a worker has sent all of a row's successors
+  void done_sending() const;
+  // whether all workers have, for rows up to row
+  bool all_sent(size_t row) const;
+  void barrier() const;
+
+  // forks the workers, worker(i) returning worker i's share of the
+  // count; false if one of them failed
+  bool run(const function<uint64_t (unsigned)> &worker, uint64_t &total) const;
+};
+
+inline unsigned shard_of(packed_config_t key, unsigned workers) {
+  // splitmix64's finalizer: neighbouring keys land far apart
+  key ^= key >> 30;
+  key *= 0xbf58476d1ce4e5b9ull;
+  key ^= key >> 27;
+  key *= 0x94d049bb133111ebull;
+  key ^= key >> 31;
+  return key % workers;
+}
+
+template<class ConfigurationT>
+uint64_t count_shard(const Grid &g, const ShardSegment &segment, unsigned me) {
+  typedef unordered_map<packed_config_t, uint64_t> table_t;
+  const unsigned n = segment.workers();
+
+  vector<Grid::Node::degree_t> target_degrees(g.cols, -1);
+  vector<vector<Grid::Node> > next_neighbors(g.cols);
+
+  table_t cur_configs, next_configs;
+  const packed_config_t initial = pack_configuration(ConfigurationT(vector<int>(g.cols, 0)));
+  if (shard_of(initial, n) == me)
+    cur_configs[initial] = 1;
+
+  const auto receive = [&]() {
+    for(unsigned from = 0; from < n; ++from) {
+      if (from != me)
+	segment.drain(segment.ring(from, me), [&](const ShardSegment::Entry &entry) {
+	    next_configs[entry.key] += entry.count;
+	  });
+    }
+  };
+
+  for(auto row : range(g.rows)) {
+    row_setup(g, row, target_degrees, next_neighbors);
+
+    for(auto &config_count : cur_configs) {
+      const uint64_t count = config_count.second;
+      const ConfigurationT config = unpack_configuration<ConfigurationT>(config_count.first, g.cols);
+      for_each_next_config<ConfigurationT>(row, config, target_degrees, next_neighbors,
+        [&](const ConfigurationT &next_config) {
+	  const packed_config_t key = pack_configuration(next_config);
+	  const unsigned owner = shard_of(key, n);
+	  if (owner == me) {
+	    next_configs[key] += count;
+	    return;
+	  }
+	  // a full ring waits for its reader, who may be waiting on ours
+	  while (not segment.try_push(segment.ring(me, owner), ShardSegment::Entry({key, count}))) {
+	    receive();
+	    sched_yield();
+	  }
+	});
+    }
+
+    segment.done_sending();
+    while (not segment.all_sent(row)) {
+      receive();
+      sched_yield();
+    }
+    receive();
+    segment.barrier();
+
+    swap(cur_configs, next_configs);
+    next_configs.clear();
+  }
+
+  uint64_t total = 0;
+  for(auto &config_count : cur_configs) {
+    total += config_count.second;
+  }
+  return total;
+}
+
+// count_paths over processes workers, each ring holding ring_entries
+template<class ConfigurationT>
+bool count_paths_sharded(const Grid &g, unsigned processes, uint64_t &total,
+			 size_t ring_entries = 1 << 14) {
+  assert(g.cols <= max_packed_cols);
+  ShardSegment segment(max(processes, 1u), ring_entries);
+  if (not segment.ok())
+    return false;
+  return segment.run([&](unsigned me) { return count_shard<ConfigurationT>(g, segment, me); }, total);
+}
+
+
+#endif
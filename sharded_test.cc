@@ -0,0 +1,64 @@
+#include "sharded.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <sstream>
+#include <vector>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+
+const vector<string> grids {
+  "4 3  2 0 0 0  0 0 0 0  0 0 3 1",
+  "5 5  2 0 0 0 0  0 1 0 0 0  0 0 0 1 0  0 0 0 0 0  1 0 0 0 3",
+  hard_grid,
+};
+
+TEST(Sharded, workers_agree_with_sweep) {
+  for(auto text : grids) {
+    Grid g = parse(text);
+    const uint64_t expected = semiring_paths<CountSemiring<uint64_t>, VectorConfig>(g);
+    for(unsigned processes : {1, 2, 3, 5}) {
+      uint64_t total = 0;
+      ASSERT_TRUE(count_paths_sharded<VectorConfig>(g, processes, total));
+      EXPECT_EQ(expected, total) << text << " on " << processes;
+    }
+  }
+}
+
+TEST(Sharded, full_rings_wait_for_readers) {
+  // rings of four entries fill up all the time, both ways at once
+  Grid g = parse(grids.back());
+  uint64_t total = 0;
+  ASSERT_TRUE(count_paths_sharded<VectorConfig>(g, 4, total, 4));
+  EXPECT_EQ(301716u, total);
+}
+
+TEST(Sharded, leaves_other_children_alone) {
+  // a child of the caller's own, done before the workers start
+  const pid_t other = fork();
+  if (other == 0)
+    _exit(7);
+  ASSERT_LT(0, other);
+  usleep(10000);
+
+  uint64_t total = 0;
+  ASSERT_TRUE(count_paths_sharded<VectorConfig>(parse(hard_grid), 3, total));
+  EXPECT_EQ(301716u, total);
+
+  int status = 0;
+  ASSERT_EQ(other, waitpid(other, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(7, WEXITSTATUS(status));
+}
+
+TEST(Sharded, shard_of_spreads_keys) {
+  vector<size_t> owned(7, 0);
+  for(packed_config_t key = 0; key < 7000; ++key) {
+    ++owned[shard_of(key, 7)];
+  }
+  for(auto count : owned) {
+    EXPECT_GT(count, 800u);
+  }
+}
@@ -0,0 +1,304 @@
+#include "simd.hh"
+
+#include <cstring>
+#include <cstdlib>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#else
+#define HAVE_X86 0
+#endif
+
+namespace simd {
+
+namespace {
+  const uint16_t none = 0xffff;
+
+  // 16 bits to 32, a zero between each
+  inline uint64_t spread(uint32_t x) {
+    x = (x | (x << 8)) & 0x00ff00ffu;
+    x = (x | (x << 4)) & 0x0f0f0f0fu;
+    x = (x | (x << 2)) & 0x33333333u;
+    x = (x | (x << 1)) & 0x55555555u;
+    return x;
+  }
+
+
+  void scalar_mask(uint16_t *config, unsigned lanes, uint32_t keep) {
+    uint16_t out[16];
+    for(unsigned col = 0; col < lanes; ++col) {
+      const uint16_t partner = config[col];
+      if (not (keep & (1u << col)))
+	out[col] = none;
+      else if (partner != none and partner != col and not (keep & (1u << partner)))
+	out[col] = col;
+      else
+	out[col] = partner;
+    }
+    memcpy(config, out, lanes * sizeof(uint16_t));
+  }
+
+  uint64_t scalar_pack(const uint16_t *config, unsigned lanes) {
+    uint64_t key = 0;
+    for(unsigned col = 0; col < lanes; ++col) {
+      const uint16_t partner = config[col];
+      const uint64_t code = (partner == none ? 0 : partner == col ? 3 : partner > col ? 1 : 2);
+      key |= code << (2 * col);
+    }
+    return key;
+  }
+
+  bool scalar_equal(const uint16_t *a, const uint16_t *b, unsigned lanes) {
+    return memcmp(a, b, lanes * sizeof(uint16_t)) == 0;
+  }
+
+  size_t scalar_hash(const uint16_t *config, unsigned lanes) {
+    uint64_t h = lanes;
+    for(unsigned i = 0; i < lanes; i += 4) {
+      uint64_t word;
+      memcpy(&word, config + i, sizeof(word));
+      h = (h ^ word) * 0x9e3779b97f4a7c15ull;
+      h ^= h >> 32;
+    }
+    return h;
+  }
+
+  void scalar_add_shifted(uint64_t *to, const uint64_t *from, size_t n, unsigned shift) {
+    for(size_t i = shift; i < n; ++i) {
+      to[i] += from[i - shift];
+    }
+  }
+
+
+#if HAVE_X86
+  // 16 bit lane i of the result is all ones iff bit (i + first) of bits is set
+  __attribute__((target("sse4.2")))
+  inline __m128i lane_flags16(uint32_t bits, unsigned first) {
+    const __m128i select = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m128i b = _mm_set1_epi16((bits >> first) & 0xff);
+    return _mm_cmpeq_epi16(_mm_and_si128(b, select), select);
+  }
+
+  // byte i of the result is all ones iff bit i of bits is set, i < 16
+  __attribute__((target("sse4.2")))
+  inline __m128i byte_flags(uint32_t bits) {
+    const __m128i select = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128,
+					 1, 2, 4, 8, 16, 32, 64, (char)128);
+    const __m128i spread_bytes = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+    const __m128i b = _mm_shuffle_epi8(_mm_cvtsi32_si128(bits), spread_bytes);
+    return _mm_cmpeq_epi8(_mm_and_si128(b, select), select);
+  }
+
+  __attribute__((target("sse4.2")))
+  inline __m128i mask_half(__m128i v, __m128i partner_dropped, uint32_t drop, unsigned first) {
+    const __m128i iota = _mm_add_epi16(_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7),
+				       _mm_set1_epi16(first));
+    const __m128i self = _mm_cmpeq_epi16(v, iota);
+    const __m128i to_self = _mm_andnot_si128(self, partner_dropped);
+    const __m128i out = _mm_blendv_epi8(v, iota, to_self);
+    return _mm_or_si128(out, lane_flags16(drop, first));
+  }
+
+  __attribute__((target("sse4.2")))
+  void sse42_mask(uint16_t *config, unsigned lanes, uint32_t keep) {
+    const uint32_t drop = ~keep;
+    const __m128i table = byte_flags(drop);
+    __m128i lo = _mm_loadu_si128((const __m128i *)config);
+    __m128i hi = lanes > 8 ? _mm_loadu_si128((const __m128i *)(config + 8)) : _mm_set1_epi16(-1);
+
+    // partners as bytes index the drop table; no_partner saturates to 0xff,
+    // which pshufb maps to zero
+    const __m128i partner_dropped = _mm_shuffle_epi8(table, _mm_packs_epi16(lo, hi));
+
+    lo = mask_half(lo, _mm_cvtepi8_epi16(partner_dropped), drop, 0);
+    _mm_storeu_si128((__m128i *)config, lo);
+    if (lanes > 8) {
+      hi = mask_half(hi, _mm_cvtepi8_epi16(_mm_srli_si128(partner_dropped, 8)), drop, 8);
+      _mm_storeu_si128((__m128i *)(config + 8), hi);
+    }
+  }
+
+  // bit 0 and bit 1 of the pack codes for eight lanes
+  __attribute__((target("sse4.2")))
+  inline void pack_half(__m128i v, unsigned first, __m128i &bit0, __m128i &bit1) {
+    const __m128i iota = _mm_add_epi16(_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7),
+				       _mm_set1_epi16(first));
+    const __m128i unused = _mm_cmpeq_epi16(v, _mm_set1_epi16(-1));
+    const __m128i self = _mm_cmpeq_epi16(v, iota);
+    const __m128i opens = _mm_cmpgt_epi16(v, iota);
+    const __m128i closes = _mm_andnot_si128(unused, _mm_cmpgt_epi16(iota, v));
+    bit0 = _mm_or_si128(opens, self);
+    bit1 = _mm_or_si128(closes, self);
+  }
+
+  __attribute__((target("sse4.2")))
+  uint64_t sse42_pack(const uint16_t *config, unsigned lanes) {
+    __m128i lo0, lo1, hi0 = _mm_setzero_si128(), hi1 = _mm_setzero_si128();
+    pack_half(_mm_loadu_si128((const __m128i *)config), 0, lo0, lo1);
+    if (lanes > 8)
+      pack_half(_mm_loadu_si128((const __m128i *)(config + 8)), 8, hi0, hi1);
+
+    const uint32_t bit0 = _mm_movemask_epi8(_mm_packs_epi16(lo0, hi0));
+    const uint32_t bit1 = _mm_movemask_epi8(_mm_packs_epi16(lo1, hi1));
+    return spread(bit0) | (spread(bit1) << 1);
+  }
+
+  __attribute__((target("sse4.2")))
+  bool sse42_equal(const uint16_t *a, const uint16_t *b, unsigned lanes) {
+    __m128i eq = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)a),
+				 _mm_loadu_si128((const __m128i *)b));
+    if (lanes > 8) {
+      eq = _mm_and_si128(eq, _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(a + 8)),
+					     _mm_loadu_si128((const __m128i *)(b + 8))));
+    }
+    return _mm_movemask_epi8(eq) == 0xffff;
+  }
+
+  // two CRC32C chains with different seeds make a 64 bit hash
+  __attribute__((target("sse4.2")))
+  size_t sse42_hash(const uint16_t *config, unsigned lanes) {
+    uint64_t a = lanes, b = 0x9e3779b9u;
+    for(unsigned i = 0; i < lanes; i += 4) {
+      uint64_t word;
+      memcpy(&word, config + i, sizeof(word));
+      a = _mm_crc32_u64(a, word);
+      b = _mm_crc32_u64(b, word ^ 0x5555555555555555ull);
+    }
+    return (a << 32) | b;
+  }
+
+
+  __attribute__((target("sse4.2")))
+  void sse42_add_shifted(uint64_t *to, const uint64_t *from, size_t n, unsigned shift) {
+    size_t i = shift;
+    for(; i + 2 <= n; i += 2) {
+      const __m128i sum = _mm_add_epi64(_mm_loadu_si128((const __m128i *)(to + i)),
+					_mm_loadu_si128((const __m128i *)(from + i - shift)));
+      _mm_storeu_si128((__m128i *)(to + i), sum);
+    }
+    for(; i < n; ++i) {
+      to[i] += from[i - shift];
+    }
+  }
+
+  __attribute__((target("avx2")))
+  void avx2_mask(uint16_t *config, unsigned lanes, uint32_t keep) {
+    if (lanes <= 8) {
+      sse42_mask(config, lanes, keep);
+      return;
+    }
+
+    const uint32_t drop = ~keep;
+    const __m256i v = _mm256_loadu_si256((const __m256i *)config);
+    const __m256i iota = _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7,
+					   8, 9, 10, 11, 12, 13, 14, 15);
+    const __m256i select = _mm256_setr_epi16(1 << 0, 1 << 1, 1 << 2, 1 << 3,
+					     1 << 4, 1 << 5, 1 << 6, 1 << 7,
+					     1 << 8, 1 << 9, 1 << 10, 1 << 11,
+					     1 << 12, 1 << 13, 1 << 14, (short)(1 << 15));
+
+    // packs works within 128 bit lanes; gather the two halves' bytes
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(v, v), 0x08);
+    const __m128i partner_bytes = _mm256_castsi256_si128(packed);
+    const __m256i partner_dropped =
+      _mm256_cvtepi8_epi16(_mm_shuffle_epi8(byte_flags(drop), partner_bytes));
+
+    const __m256i self = _mm256_cmpeq_epi16(v, iota);
+    const __m256i to_self = _mm256_andnot_si256(self, partner_dropped);
+    __m256i out = _mm256_blendv_epi8(v, iota, to_self);
+
+    const __m256i d = _mm256_set1_epi16(drop & 0xffff);
+    out = _mm256_or_si256(out, _mm256_cmpeq_epi16(_mm256_and_si256(d, select), select));
+    _mm256_storeu_si256((__m256i *)config, out);
+  }
+
+  __attribute__((target("avx2")))
+  uint64_t avx2_pack(const uint16_t *config, unsigned lanes) {
+    if (lanes <= 8)
+      return sse42_pack(config, lanes);
+
+    const __m256i v = _mm256_loadu_si256((const __m256i *)config);
+    const __m256i iota = _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7,
+					   8, 9, 10, 11, 12, 13, 14, 15);
+    const __m256i unused = _mm256_cmpeq_epi16(v, _mm256_set1_epi16(-1));
+    const __m256i self = _mm256_cmpeq_epi16(v, iota);
+    const __m256i bit0 = _mm256_or_si256(_mm256_cmpgt_epi16(v, iota), self);
+    const __m256i bit1 = _mm256_or_si256(_mm256_andnot_si256(unused, _mm256_cmpgt_epi16(iota, v)),
+					 self);
+
+    // bytes: bit0 of lanes 0-7, bit1 of 0-7, bit0 of 8-15, bit1 of 8-15
+    const uint32_t m = _mm256_movemask_epi8(_mm256_packs_epi16(bit0, bit1));
+    const uint32_t lo = (m & 0xff) | ((m >> 8) & 0xff00);
+    const uint32_t hi = ((m >> 8) & 0xff) | ((m >> 16) & 0xff00);
+    return spread(lo) | (spread(hi) << 1);
+  }
+
+  __attribute__((target("avx2")))
+  bool avx2_equal(const uint16_t *a, const uint16_t *b, unsigned lanes) {
+    if (lanes <= 8)
+      return sse42_equal(a, b, lanes);
+    const __m256i eq = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)a),
+					  _mm256_loadu_si256((const __m256i *)b));
+    return (uint32_t)_mm256_movemask_epi8(eq) == 0xffffffffu;
+  }
+
+  __attribute__((target("avx2")))
+  void avx2_add_shifted(uint64_t *to, const uint64_t *from, size_t n, unsigned shift) {
+    size_t i = shift;
+    for(; i + 4 <= n; i += 4) {
+      const __m256i sum = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *)(to + i)),
+					   _mm256_loadu_si256((const __m256i *)(from + i - shift)));
+      _mm256_storeu_si256((__m256i *)(to + i), sum);
+    }
+    for(; i < n; ++i) {
+      to[i] += from[i - shift];
+    }
+  }
+#endif
+}
+
+const Kernels scalar_kernels = {"scalar", scalar_mask, scalar_pack, scalar_equal, scalar_hash,
+				scalar_add_shifted};
+#if HAVE_X86
+const Kernels sse42_kernels = {"sse4.2", sse42_mask, sse42_pack, sse42_equal, sse42_hash,
+			       sse42_add_shifted};
+const Kernels avx2_kernels = {"avx2", avx2_mask, avx2_pack, avx2_equal, sse42_hash,
+			      avx2_add_shifted};
+#else
+const Kernels sse42_kernels = scalar_kernels;
+const Kernels avx2_kernels = scalar_kernels;
+#endif
+
+bool have_sse42() {
+#if HAVE_X86
+  return __builtin_cpu_supports("sse4.2");
+#else
+  return false;
+#endif
+}
+
+bool have_avx2() {
+#if HAVE_X86
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+// COUNT_SIMD=scalar|sse4.2|avx2 caps the choice, for comparisons
+const Kernels &kernels() {
+  static const Kernels &chosen = []() -> const Kernels & {
+    const char *env = getenv("COUNT_SIMD");
+    const std::string cap = env ? env : "avx2";
+    if (cap == "avx2" and have_avx2())
+      return avx2_kernels;
+    if ((cap == "avx2" or cap == "sse4.2") and have_sse42())
+      return sse42_kernels;
+    return scalar_kernels;
+  }();
+  return chosen;
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef __SIMD_HH__
+#define __SIMD_HH__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Vector kernels for fixed-capacity configurations of 8 or 16 unsigned
+// short partners: the whole frontier sits in one or two SSE registers, or
+// one AVX2 register.  Lanes past the configuration's size must hold
+// no_partner (all ones); the kernels treat every lane alike.  One more
+// adds truncated polynomials of 64 bit counts, two or four at a time.
+//
+// The implementation is picked once, at first use, from the CPU: AVX2,
+// else SSE4.2, else plain C++.
+namespace simd {
+  struct Kernels {
+    const char *name;
+
+    // drops every column whose bit in keep is clear, as Configuration::mask
+    void (*mask)(uint16_t *config, unsigned lanes, uint32_t keep);
+
+    // the two bit codes of pack_configuration
+    uint64_t (*pack)(const uint16_t *config, unsigned lanes);
+
+    bool (*equal)(const uint16_t *a, const uint16_t *b, unsigned lanes);
+
+    size_t (*hash)(const uint16_t *config, unsigned lanes);
+
+    // to[i + shift] += from[i] for i + shift < n: adds a polynomial of n
+    // coefficients times x^shift, truncated, see histogram.hh
+    void (*add_shifted)(uint64_t *to, const uint64_t *from, size_t n, unsigned shift);
+  };
+
+  extern const Kernels scalar_kernels;
+  extern const Kernels sse42_kernels;
+  extern const Kernels avx2_kernels;
+
+  bool have_sse42();
+  bool have_avx2();
+
+  const Kernels &kernels();
+}
+
+
+#endif
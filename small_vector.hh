@@ -0,0 +1,112 @@
+#ifndef __SMALL_VECTOR_HH__
+#define __SMALL_VECTOR_HH__
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+using namespace std;
+
+// A vector that keeps up to N elements inline and only goes to the heap
+// beyond that.  The size is fixed at assign(); that is all Configuration
+// needs, so there is no push_back.
+template<class T, size_t N>
+class small_vector {
+  T *_data;
+  size_t _size;
+  T _inline[N];
+
+  void allocate(size_t count) {
+    _size = count;
+    _data = count > N ? new T[count] : _inline;
+  }
+
+  void release() {
+    if (_data != _inline)
+      delete[] _data;
+    _data = _inline;
+    _size = 0;
+  }
+
+public:
+  typedef T value_type;
+  typedef T *iterator;
+  typedef const T *const_iterator;
+
+  small_vector() : _data(_inline), _size(0) {}
+
+  small_vector(const small_vector &other) {
+    allocate(other._size);
+    copy(other.begin(), other.end(), _data);
+  }
+
+  small_vector(small_vector &&other) {
+    if (other._data == other._inline) {
+      allocate(other._size);
+      copy(other.begin(), other.end(), _data);
+    } else {
+      _data = other._data;
+      _size = other._size;
+      other._data = other._inline;
+      other._size = 0;
+    }
+  }
+
+  ~small_vector() { release(); }
+
+  small_vector &operator=(const small_vector &other) {
+    if (this != &other) {
+      if (_size != other._size) {
+	release();
+	allocate(other._size);
+      }
+      copy(other.begin(), other.end(), _data);
+    }
+    return *this;
+  }
+
+  small_vector &operator=(small_vector &&other) {
+    if (this != &other) {
+      if (other._data == other._inline) {
+	*this = static_cast<const small_vector &>(other);
+      } else {
+	release();
+	_data = other._data;
+	_size = other._size;
+	other._data = other._inline;
+	other._size = 0;
+      }
+    }
+    return *this;
+  }
+
+  void assign(size_t count, const T &value) {
+    if (count != _size) {
+      release();
+      allocate(count);
+    }
+    fill(_data, _data + _size, value);
+  }
+
+  size_t size() const { return _size; }
+  T *data() { return _data; }
+  const T *data() const { return _data; }
+
+  T &operator[](size_t i) { return _data[i]; }
+  const T &operator[](size_t i) const { return _data[i]; }
+
+  iterator begin() { return _data; }
+  iterator end() { return _data + _size; }
+  const_iterator begin() const { return _data; }
+  const_iterator end() const { return _data + _size; }
+
+  friend bool operator==(const small_vector &a, const small_vector &b) {
+    return a._size == b._size and equal(a.begin(), a.end(), b.begin());
+  }
+
+  friend bool operator<(const small_vector &a, const small_vector &b) {
+    return lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+  }
+};
+
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef __SORT_REDUCE_HH__
+#define __SORT_REDUCE_HH__
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <stdint.h>
+
+#include "count_paths.hh"
+#include "packed.hh"
+#include "page_alloc.hh"
+#include "varint.hh"
+using namespace std;
+
+// Sort-and-reduce aggregation: instead of hashing every successor into
+// next_configs, append (key, count) pairs to a flat buffer, radix sort it
+// and sum runs of equal keys.  A row's frontier is then a dense sorted
+// array, cheap to stream, to store and to merge with another one.
+
+template<class count_t>
+struct KeyCount {
+  packed_config_t key;
+  count_t count;
+};
+
+template<class count_t>
+using frontier_table_t = vector< KeyCount<count_t>, page_allocator< KeyCount<count_t> > >;
+
+// LSD radix sort on the key, eight bits a pass, skipping the byte
+// positions in which no two keys differ.
+template<class count_t>
+void radix_sort(frontier_table_t<count_t> &table, frontier_table_t<count_t> &scratch) {
+  if (table.size() < 2)
+    return;
+
+  packed_config_t any = 0, all = ~(packed_config_t)0;
+  for(auto &entry : table) {
+    any |= entry.key;
+    all &= entry.key;
+  }
+  const packed_config_t varying = any ^ all;
+
+  scratch.resize(table.size());
+  for(int shift = 0; shift < 64; shift += 8) {
+    if (((varying >> shift) & 0xff) == 0)
+      continue;
+
+    size_t offsets[257] = {0};
+    for(auto &entry : table) {
+      ++offsets[((entry.key >> shift) & 0xff) + 1];
+    }
+    for(int digit = 0; digit < 256; ++digit) {
+      offsets[digit + 1] += offsets[digit];
+    }
+    for(auto &entry : table) {
+      scratch[offsets[(entry.key >> shift) & 0xff]++] = entry;
+    }
+    swap(table, scratch);
+  }
+}
+
+// sums the counts of adjacent equal keys in place
+template<class count_t>
+void reduce_sorted(frontier_table_t<count_t> &table) {
+  size_t out = 0;
+  for(size_t in = 0; in < table.size(); ++in) {
+    if (out > 0 and table[out - 1].key == table[in].key) {
+      table[out - 1].count += table[in].count;
+    } else {
+      table[out++] = table[in];
+    }
+  }
+  table.resize(out);
+}
+
+// merges two sorted, reduced tables into a sorted, reduced table
+template<class count_t>
+frontier_table_t<count_t> merge_reduce(const frontier_table_t<count_t> &a,
+				       const frontier_table_t<count_t> &b) {
+  frontier_table_t<count_t> out;
+  out.reserve(a.size() + b.size());
+  auto ia = begin(a), ib = begin(b);
+  while (ia != end(a) and ib != end(b)) {
+    if (ia->key < ib->key) {
+      out.push_back(*ia++);
+    } else if (ib->key < ia->key) {
+      out.push_back(*ib++);
+    } else {
+      out.push_back(KeyCount<count_t>({ia->key, ia->count + ib->count}));
+      ++ia, ++ib;
+    }
+  }
+  out.insert(end(out), ia, end(a));
+  out.insert(end(out), ib, end(b));
+  return out;
+}
+
+// A sorted, reduced table frozen once its row is complete: the next row
+// only streams through it.  Entries are grouped in blocks; a block holds
+// its first key in full and every other key as the difference to the one
+// before, and all counts, as varints.  Sorted keys of one row share most
+// of their high bits, so the deltas are short, and most counts are small.
+// Blocks decode independently, so workers can each take a range of them.
+template<class count_t>
+class FrozenTable {
+  vector<uint8_t, page_allocator<uint8_t> > bytes;
+  vector<size_t> block_starts;  // offset of each block in bytes
+  size_t entries;
+
+public:
+  static const size_t block_size = 128;
+
+  FrozenTable() : entries(0) {}
+
+  explicit FrozenTable(const frontier_table_t<count_t> &table) : entries(table.size()) {
+    size_t size = 0;
+    for(size_t i = 0; i < table.size(); ++i) {
+      size += varint_size(i % block_size ? table[i].key - table[i - 1].key : table[i].key);
+      size += varint_size(table[i].count);
+    }
+    bytes.reserve(size);
+    block_starts.reserve((table.size() + block_size - 1) / block_size);
+
+    packed_config_t last = 0;
+    for(size_t i = 0; i < table.size(); ++i) {
+      if (i % block_size == 0) {
+	block_starts.push_back(bytes.size());
+	last = 0;
+      }
+      assert(table[i].key >= last);
+      append_varint(bytes, table[i].key - last);
+      append_varint(bytes, table[i].count);
+      last = table[i].key;
+    }
+  }
+
+  size_t size() const { return entries; }
+  size_t blocks() const { return block_starts.size(); }
+  size_t memory() const { return bytes.capacity() + block_starts.capacity() * sizeof(size_t); }
+
+  // action(key, count) for the entries of blocks first to last, exclusive
+  template<class F>
+  void for_each(size_t first, size_t last, F action) const {
+    if (first >= last)
+      return;
+    const uint8_t *p = bytes.data() + block_starts[first];
+    const size_t end_entry = min(entries, last * block_size);
+    packed_config_t key = 0;
+    for(size_t i = first * block_size; i < end_entry; ++i) {
+      uint64_t delta, count;
+      p = read_varint(p, delta);
+      p = read_varint(p, count);
+      key = i % block_size == 0 ? delta : key + delta;
+      action(key, (count_t)count);
+    }
+  }
+
+  template<class F>
+  void for_each(F action) const { for_each(0, blocks(), action); }
+};
+
+// count_paths with sort-and-reduce aggregation.  Each of the threads
+// expands a contiguous run of blocks of the current row, which is kept
+// frozen, into its own buffer and sorts and reduces it; the partial tables
+// are then merged pairwise and frozen for the next row.
+template<class ConfigurationT>
+int count_paths_sorted(Grid g, unsigned threads) {
+  typedef unsigned int count_t;
+  typedef frontier_table_t<count_t> table_t;
+
+  assert(g.cols <= max_packed_cols);
+  threads = max(threads, 1u);
+
+  vector<Grid::Node::degree_t> target_degrees(g.cols, -1);
+  vector<vector<Grid::Node> > next_neighbors(g.cols);
+
+  ConfigurationT initial_config(vector<int>(g.cols, 0));
+  FrozenTable<count_t> cur_configs(table_t{{pack_configuration(initial_config), 1}});
+
+  for(auto row : range(g.rows)) {
+    row_setup(g, row, target_degrees, next_neighbors);
+
+    const size_t chunks = min<size_t>(threads, max<size_t>(cur_configs.size() / 1024, 1));
+    vector<table_t> partial(chunks);
+
+    const auto expand = [&](size_t chunk) {
+      table_t &out = partial[chunk];
+      table_t scratch;
+      const size_t first = cur_configs.blocks() * chunk / chunks;
+      const size_t last = cur_configs.blocks() * (chunk + 1) / chunks;
+      size_t reduce_at = 1 << 16;
+
+      cur_configs.for_each(first, last, [&](packed_config_t cur_key, count_t cur_count) {
+	const ConfigurationT cur_config = unpack_configuration<ConfigurationT>(cur_key, g.cols);
+	for_each_next_config<ConfigurationT>(row, cur_config, target_degrees, next_neighbors,
+	  [&](const ConfigurationT &next_config) {
+	    out.push_back(KeyCount<count_t>({pack_configuration(next_config), cur_count}));
+	  });
+	// the duplicates of the buffer need not wait for the end of the row
+	if (out.size() >= reduce_at) {
+	  radix_sort(out, scratch);
+	  reduce_sorted(out);
+	  reduce_at = max(reduce_at, 4 * out.size());
+	}
+      });
+
+      radix_sort(out, scratch);
+      reduce_sorted(out);
+    };
+
+    vector<thread> workers;
+    for(size_t chunk = 1; chunk < chunks; ++chunk) {
+      workers.emplace_back(expand, chunk);
+    }
+    expand(0);
+    for(auto &worker : workers) {
+      worker.join();
+    }
+
+    for(size_t width = 1; width < chunks; width *= 2) {
+      for(size_t i = 0; i + width < chunks; i += 2 * width) {
+	partial[i] = merge_reduce(partial[i], partial[i + width]);
+	table_t().swap(partial[i + width]);
+      }
+    }
+
+    cur_configs = FrozenTable<count_t>(partial[0]);
+  }
+
+  int total = 0;
+  cur_configs.for_each([&](packed_config_t, count_t count) { total += count; });
+  return total;
+}
+
+
+#endif
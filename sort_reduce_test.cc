@@ -0,0 +1,52 @@
+#include "sort_reduce.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <random>
+#include <vector>
+#include <string>
+using namespace std;
+
+const vector<string> grids {
+  "4 3  2 0 0 0  0 0 0 0  0 0 3 1",
+  "5 4  2 0 0 0 0  0 0 0 0 0  0 0 0 0 0  3 0 0 0 0",
+  "5 5  2 0 0 0 0  0 1 0 0 0  0 0 0 1 0  0 0 0 0 0  1 0 0 0 3",
+  "6 5  0 0 0 0 0 0  0 2 0 0 0 0  0 0 1 1 0 0  0 0 0 0 3 0  0 0 0 0 0 0",
+  "7 3  2 0 0 0 0 0 0  0 0 0 0 0 0 0  0 0 0 0 0 0 3",
+  hard_grid,
+};
+
+TEST(Frozen, round_trip) {
+  mt19937 rng(3);
+  frontier_table_t<unsigned int> table;
+  packed_config_t key = 0;
+  for(int i = 0; i < 1000; ++i) {
+    key += 1 + rng() % (i % 100 == 0 ? 1u << 30 : 50);
+    table.push_back(KeyCount<unsigned int>({key, (unsigned)(i % 7 == 0 ? rng() : 1 + rng() % 5)}));
+  }
+
+  FrozenTable<unsigned int> frozen(table);
+  EXPECT_EQ(table.size(), frozen.size());
+  EXPECT_LT(frozen.memory(), table.size() * sizeof(table[0]) / 2);
+
+  // the blocks in two ranges, as two workers would see them
+  size_t i = 0;
+  const auto check = [&](packed_config_t key, unsigned int count) {
+    ASSERT_LT(i, table.size());
+    EXPECT_EQ(table[i].key, key);
+    EXPECT_EQ(table[i].count, count);
+    ++i;
+  };
+  frozen.for_each(0, 3, check);
+  EXPECT_EQ(3 * FrozenTable<unsigned int>::block_size, i);
+  frozen.for_each(3, frozen.blocks(), check);
+  EXPECT_EQ(table.size(), i);
+}
+
+TEST(Frozen, sorted_sweep) {
+  for(auto text : grids) {
+    Grid grid = parse(text);
+    EXPECT_EQ(count_paths<VectorConfig>(grid), count_paths_sorted<VectorConfig>(grid, 1)) << text;
+    EXPECT_EQ(count_paths<VectorConfig>(grid), count_paths_sorted<VectorConfig>(grid, 4)) << text;
+  }
+}
@@ -0,0 +1,131 @@
+#include "sweep_control.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+  size_t resident_bytes() {
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+  }
+
+  string clock_time(double seconds) {
+    const long s = lround(seconds);
+    ostringstream os;
+    os << s / 3600 << ":" << setfill('0') << setw(2) << s / 60 % 60 << ":" << setw(2) << s % 60;
+    return os.str();
+  }
+}
+
+SweepControl::SweepControl(const SweepLimits &limits, size_t rows) :
+  limits(limits),
+  rows(rows),
+  start(clock::now()),
+  row_start(start),
+  last_report(start),
+  row(0),
+  row_states(0),
+  done(0),
+  ticks(0)
+{}
+
+bool SweepControl::start_row(size_t row_, size_t states) {
+  row = row_;
+  row_states = states;
+  done = 0;
+  row_start = clock::now();
+  return poll();
+}
+
+void SweepControl::finish_row(size_t states) {
+  const double seconds = chrono::duration<double>(clock::now() - row_start).count();
+  states_in.push_back(row_states);
+  states_out.push_back(states);
+  row_seconds.push_back(seconds);
+  if (row + 1 == rows)
+    report(true);
+}
+
+bool SweepControl::poll() {
+  const auto now = clock::now();
+  const double elapsed = chrono::duration<double>(now - start).count();
+
+  if (limits.time_limit > 0 and elapsed >= limits.time_limit) {
+    why = "time limit";
+  } else if (limits.memory_limit > 0 and resident_bytes() >= limits.memory_limit) {
+    why = "memory limit";
+  }
+
+  if (stopped() or (limits.progress_interval > 0 and
+		    chrono::duration<double>(now - last_report).count() >= limits.progress_interval)) {
+    last_report = now;
+    report(false);
+  }
+
+  return not stopped();
+}
+
+void SweepControl::report(bool final) {
+  if (limits.progress_interval <= 0 and not stopped())
+    return;
+
+  const double elapsed = chrono::duration<double>(clock::now() - start).count();
+  ostringstream os;
+  os << "row " << row + 1 << "/" << rows << ", " << row_states << " states";
+
+  if (final) {
+    os << ", done in " << clock_time(elapsed);
+  } else if (stopped()) {
+    os << ", stopped by the " << why << " after " << clock_time(elapsed);
+  } else {
+    // seconds per state: the rows so far, and this one as far as it got
+    double seconds = chrono::duration<double>(clock::now() - row_start).count();
+    size_t states = done;
+    for(size_t i = 0; i < row_seconds.size(); ++i) {
+      seconds += row_seconds[i];
+      states += states_in[i];
+    }
+    const double per_state = states > 0 ? seconds / states : 0;
+
+    // The state count grows by the last row's ratio, and the excess of
+    // that ratio over one shrinks by as much as it did from the row
+    // before; the frontier is bounded, so it does shrink.
+    const auto ratio = [&](size_t i) {
+      return states_in[i] > 0 ? (double)states_out[i] / states_in[i] : 1.0;
+    };
+    const size_t n = states_in.size();
+    double growth = n > 0 ? ratio(n - 1) : 1, decay = 0.5;
+    if (n > 1 and ratio(n - 2) > 1 and growth > 1)
+      decay = min(1.0, (growth - 1) / (ratio(n - 2) - 1));
+
+    double remaining = row_states > done ? row_states - done : 0;
+    double next = row_states;
+    for(size_t r = row + 1; r < rows; ++r) {
+      next *= growth;
+      remaining += next;
+      growth = 1 + (growth - 1) * decay;
+    }
+
+    os << ", " << lround(per_state > 0 ? 1 / per_state : 0) << " states/s"
+       << ", elapsed " << clock_time(elapsed);
+    if (per_state > 0)
+      os << ", eta " << clock_time(remaining * per_state);
+  }
+
+  if (limits.status_file.empty()) {
+    cerr << os.str() << endl;
+  } else {
+    // replaced whole, so a reader never sees half a line
+    const string temporary = limits.status_file + ".tmp";
+    ofstream status(temporary);
+    status << os.str() << endl;
+    status.close();
+    rename(temporary.c_str(), limits.status_file.c_str());
+  }
+}
@@ -0,0 +1,167 @@
+#ifndef __SWEEP_CONTROL_HH__
+#define __SWEEP_CONTROL_HH__
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+#include "grid.hh"
+#include "varint.hh"
+#include "range.hh"
+using namespace std;
+
+struct SweepLimits {
+  double progress_interval;  // seconds between progress reports, 0 for none
+  string status_file;        // where they go, stderr if empty
+  double time_limit;         // seconds, 0 for none
+  size_t memory_limit;       // bytes of resident memory, 0 for none
+  string snapshot_file;      // where a stopped sweep leaves its states
+  string resume_file;        // a snapshot to continue from
+
+  SweepLimits() : progress_interval(0), time_limit(0), memory_limit(0) {}
+};
+
+// Watches a row sweep from the inside.  The sweep reports the start and
+// end of every row and calls keep_going once per state; every so often
+// that looks at the clock and the resident memory, prints progress and
+// says whether a limit has been hit.  The remaining time is projected from
+// the seconds per state of the rows so far and the growth of the state
+// count over the last few rows.
+class SweepControl {
+  typedef chrono::steady_clock clock;
+
+  const SweepLimits limits;
+  const size_t rows;
+  const clock::time_point start;
+  clock::time_point row_start, last_report;
+
+  size_t row, row_states, done;
+  unsigned ticks;
+  vector<size_t> states_in, states_out;
+  vector<double> row_seconds;
+  string why;
+
+  bool poll();
+  void report(bool final);
+
+public:
+  SweepControl(const SweepLimits &limits, size_t rows);
+
+  // false if the sweep should stop before the row
+  bool start_row(size_t row, size_t states);
+
+  // false if the sweep should stop now; the row is then lost
+  bool keep_going() {
+    ++done;
+    return (++ticks & 1023) != 0 or poll();
+  }
+
+  void finish_row(size_t states);
+
+  void stop(const string &reason) { why = reason; }
+  bool stopped() const { return not why.empty(); }
+  const string &reason() const { return why; }
+  size_t stopped_row() const { return row; }
+
+  const SweepLimits &settings() const { return limits; }
+};
+
+// A stopped sweep's snapshot: the states carried into the row it stopped
+// at, with their semiring values, and enough of the grid and the
+// computation to refuse to resume anything else.
+//
+// Layout: magic, version, kind, grid codes, columns, row, state count,
+// then every state as its partners (plus one, zero for none) and its value
+// zigzag coded, all varints.
+namespace snapshot {
+  const char magic[4] = {'H', 'S', 'N', 'P'};
+  const uint8_t format_version = 1;
+
+  inline void put_string(ostream &os, const string &s) {
+    put_varint(os, s.size());
+    os.write(s.data(), s.size());
+  }
+
+  inline bool get_string(istream &is, string &s) {
+    uint64_t size;
+    if (not get_varint(is, size) or size > (1u << 30))
+      return false;
+    s.resize(size);
+    return (bool)is.read(&s[0], size);
+  }
+
+  inline uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+  inline int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+  template<class Table>
+  bool save(const string &file, const string &kind, const Grid &g, size_t row, const Table &states) {
+    ofstream os(file, ios::binary);
+    os.write(magic, sizeof(magic));
+    os.put((char)format_version);
+    put_string(os, kind);
+    put_string(os, g.codes());
+    put_varint(os, g.cols);
+    put_varint(os, row);
+    put_varint(os, states.size());
+    for(auto &state : states) {
+      for(auto col : range(g.cols)) {
+	const auto partner = state.first.config[col];
+	put_varint(os, partner == state.first.no_partner ? 0 : partner + 1);
+      }
+      put_varint(os, zigzag((int64_t)state.second.value));
+    }
+    return (bool)os;
+  }
+
+  // false, leaving states alone, unless file is a snapshot of kind on g
+  template<class Table>
+  bool load(const string &file, const string &kind, const Grid &g, size_t &row, Table &states) {
+    typedef typename Table::key_type config_t;
+    typedef decltype(states.begin()->second.value) value_t;
+
+    ifstream is(file, ios::binary);
+    char header[sizeof(magic)];
+    if (not is.read(header, sizeof(header)) or not equal(header, header + sizeof(magic), magic))
+      return false;
+    if (is.get() != format_version)
+      return false;
+
+    string file_kind, codes;
+    uint64_t cols, file_row, count;
+    if (not get_string(is, file_kind) or file_kind != kind or
+	not get_string(is, codes) or codes != g.codes() or
+	not get_varint(is, cols) or cols != g.cols or
+	not get_varint(is, file_row) or file_row >= g.rows or
+	not get_varint(is, count))
+      return false;
+
+    Table loaded;
+    for(uint64_t i = 0; i < count; ++i) {
+      config_t config(vector<int>(g.cols, 0));
+      for(auto col : range(g.cols)) {
+	uint64_t partner;
+	if (not get_varint(is, partner) or partner > g.cols)
+	  return false;
+	if (partner > 0)
+	  config.config[col] = partner - 1;
+      }
+      for(auto col : range(g.cols)) {
+	const auto partner = config.config[col];
+	if (partner != config.no_partner and config.config[partner] != col)
+	  return false;
+      }
+      uint64_t value;
+      if (not get_varint(is, value))
+	return false;
+      loaded[config].value = (value_t)unzigzag(value);
+    }
+
+    row = file_row;
+    swap(states, loaded);
+    return true;
+  }
+}
+
+
+#endif
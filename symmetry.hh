@@ -0,0 +1,178 @@
+#ifndef __SYMMETRY_HH__
+#define __SYMMETRY_HH__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "count_paths.hh"
+using namespace std;
+
+// The row sweep folded along the grid's vertical axis.  A row whose cells,
+// and the blocked cells of the row below, read the same from either side
+// turns a state's mirror image into the mirror images of its successors.
+// So
+//   - while every row swept so far is mirrored, the states come in mirror
+//     pairs of equal count: only the lesser of each pair is kept, with its
+//     own count, and the pairs are unfolded at the first row that is not;
+//   - once every row still to sweep is mirrored, a state and its mirror
+//     image complete to as many layouts: the pair is merged into the
+//     lesser, with the sum of their counts.
+// Either way about half the states are carried.  Counts are modulo 2^64.
+
+// whether row's cells, and the blocked cells below them, are mirrored
+inline bool mirrored_row(const Grid &g, const string &codes, size_t row) {
+  for(size_t col = 0; col < g.cols / 2; ++col) {
+    const size_t other = g.cols - 1 - col;
+    if (codes[row * g.cols + col] != codes[row * g.cols + other])
+      return false;
+    if (row + 1 < g.rows and
+	(codes[(row + 1) * g.cols + col] == '1') != (codes[(row + 1) * g.cols + other] == '1'))
+      return false;
+  }
+  return true;
+}
+
+template<class ConfigurationT>
+ConfigurationT mirror_image(const ConfigurationT &config) {
+  const size_t n = config.size();
+  ConfigurationT image(config);
+  for(size_t col = 0; col < n; ++col) {
+    const auto partner = config.config[col];
+    image.config[n - 1 - col] = partner == ConfigurationT::no_partner ? partner : n - 1 - partner;
+  }
+  return image;
+}
+
+template<class ConfigurationT>
+class MirrorSweep {
+  typedef unordered_map<ConfigurationT, uint64_t> config_map_t;
+
+  const Grid &g;
+  vector<Grid::Node::degree_t> target_degrees;
+  vector<vector<Grid::Node> > next_neighbors;
+
+  static ConfigurationT canonical(const ConfigurationT &config) {
+    const ConfigurationT image = mirror_image(config);
+    return image < config ? image : config;
+  }
+
+  // Rows swept so far mirrored: every kept state stands for itself and
+  // its image, each with the kept count.  A kept state on the axis sends
+  // its count to both images of a successor off it, so only one of them
+  // is taken; one off the axis sends it to a successor on it twice.
+  void step_pairs(size_t row, config_map_t &cur_configs) {
+    config_map_t next_configs;
+    for(auto &config_count : cur_configs) {
+      const uint64_t count = config_count.second;
+      const bool on_axis = mirror_image(config_count.first) == config_count.first;
+      for_each_next_config<ConfigurationT>(row, config_count.first, target_degrees, next_neighbors,
+        [&](const ConfigurationT &next_config) {
+	  const ConfigurationT image = mirror_image(next_config);
+	  if (image == next_config)
+	    next_configs[next_config] += on_axis ? count : 2 * count;
+	  else if (not on_axis)
+	    next_configs[image < next_config ? image : next_config] += count;
+	  else if (next_config < image)
+	    next_configs[next_config] += count;
+	});
+    }
+    swap(cur_configs, next_configs);
+  }
+
+  // rows still to sweep mirrored: a kept state is itself and its image
+  void step_merged(size_t row, config_map_t &cur_configs) {
+    config_map_t next_configs;
+    for(auto &config_count : cur_configs) {
+      const uint64_t count = config_count.second;
+      for_each_next_config<ConfigurationT>(row, config_count.first, target_degrees, next_neighbors,
+        [&](const ConfigurationT &next_config) {
+	  next_configs[canonical(next_config)] += count;
+	});
+    }
+    swap(cur_configs, next_configs);
+  }
+
+  void step(size_t row, config_map_t &cur_configs) {
+    config_map_t next_configs;
+    for(auto &config_count : cur_configs) {
+      const uint64_t count = config_count.second;
+      for_each_next_config<ConfigurationT>(row, config_count.first, target_degrees, next_neighbors,
+        [&](const ConfigurationT &next_config) {
+	  next_configs[next_config] += count;
+	});
+    }
+    swap(cur_configs, next_configs);
+  }
+
+  // each pair as both its states, or, with merge, as their sum
+  static void unfold(config_map_t &cur_configs, bool merge) {
+    config_map_t unfolded;
+    for(auto &config_count : cur_configs) {
+      const ConfigurationT image = mirror_image(config_count.first);
+      if (image == config_count.first) {
+	unfolded[image] += config_count.second;
+      } else if (merge) {
+	unfolded[config_count.first] += 2 * config_count.second;
+      } else {
+	unfolded[config_count.first] += config_count.second;
+	unfolded[image] += config_count.second;
+      }
+    }
+    swap(cur_configs, unfolded);
+  }
+
+public:
+  size_t paired_rows, merged_rows;  // rows swept folded either way
+  size_t max_states;                // the most states kept after a row
+
+  MirrorSweep(const Grid &g_) : g(g_), paired_rows(0), merged_rows(0), max_states(0) {}
+
+  uint64_t run() {
+    const string codes = g.codes();
+    // rows from merge_from on are all mirrored
+    size_t merge_from = g.rows;
+    while (merge_from > 0 and mirrored_row(g, codes, merge_from - 1))
+      --merge_from;
+
+    config_map_t cur_configs;
+    cur_configs[ConfigurationT(vector<int>(g.cols, 0))] = 1;
+    bool paired = true;
+
+    for(size_t row = 0; row < g.rows; ++row) {
+      row_setup(g, row, target_degrees, next_neighbors);
+      if (paired and mirrored_row(g, codes, row)) {
+	step_pairs(row, cur_configs);
+	++paired_rows;
+      } else if (row >= merge_from) {
+	if (paired)
+	  unfold(cur_configs, true);
+	paired = false;
+	step_merged(row, cur_configs);
+	++merged_rows;
+      } else {
+	if (paired)
+	  unfold(cur_configs, false);
+	paired = false;
+	step(row, cur_configs);
+      }
+      max_states = max(max_states, cur_configs.size());
+    }
+
+    uint64_t total = 0;
+    for(auto &config_count : cur_configs) {
+      const bool on_axis = mirror_image(config_count.first) == config_count.first;
+      total += paired and not on_axis ? 2 * config_count.second : config_count.second;
+    }
+    return total;
+  }
+};
+
+template<class ConfigurationT>
+uint64_t count_paths_mirrored(const Grid &g) {
+  return MirrorSweep<ConfigurationT>(g).run();
+}
+
+
+#endif
@@ -0,0 +1,117 @@
+#include "symmetry.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <random>
+#include <sstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+// cols x rows of rooms with random blocked cells, mirrored in the rows
+// from mirror_from to mirror_to, with the intake at (start_row, start_col)
+// and the AC at (end_row, end_col)
+Grid random_grid(mt19937 &rng, int cols, int rows, int mirror_from, int mirror_to,
+		 int start_row, int start_col, int end_row, int end_col) {
+  vector<int> cells(cols * rows, 0);
+  for(auto &cell : cells) {
+    cell = rng() % 5 == 0;
+  }
+  for(int row = mirror_from; row < mirror_to; ++row) {
+    for(int col = 0; col < cols / 2; ++col) {
+      cells[row * cols + cols - 1 - col] = cells[row * cols + col];
+    }
+  }
+  cells[start_row * cols + start_col] = 2;
+  cells[end_row * cols + end_col] = 3;
+
+  ostringstream text;
+  text << cols << " " << rows;
+  for(auto cell : cells) {
+    text << " " << cell;
+  }
+  return parse(text.str());
+}
+
+TEST(Symmetry, mirror_images) {
+  const VectorConfig config("1200230");
+  EXPECT_EQ(VectorConfig("0320021"), mirror_image(config));
+  EXPECT_EQ(config, mirror_image(mirror_image(config)));
+  EXPECT_EQ(VectorConfig("10201"), mirror_image(VectorConfig("10201")));
+
+  const Grid g = parse("3 2  0 2 0  1 0 3");
+  const string codes = g.codes();
+  EXPECT_FALSE(mirrored_row(g, codes, 0));
+  EXPECT_FALSE(mirrored_row(g, codes, 1));
+  EXPECT_TRUE(mirrored_row(parse("3 2  0 2 0  0 3 0"), "020030", 0));
+}
+
+TEST(Symmetry, folded_sweeps_match) {
+  mt19937 rng(41);
+  for(int i = 0; i < 300; ++i) {
+    const int cols = 2 + rng() % 7, rows = 2 + rng() % 7, middle = cols / 2;
+    const int split = rng() % (rows + 1);
+    Grid g = parse("1 1 0");
+    switch (i % 4) {
+    case 0:  // all mirrored, the endpoints on the axis
+      g = random_grid(rng, cols, rows, 0, rows, 0, middle, rows - 1, middle);
+      break;
+    case 1:  // mirrored above split, the intake on the axis
+      g = random_grid(rng, cols, rows, 0, split, 0, middle, rows - 1, rng() % cols);
+      break;
+    case 2:  // mirrored below split, the AC on the axis
+      g = random_grid(rng, cols, rows, split, rows, 0, rng() % cols, rows - 1, middle);
+      break;
+    default:
+      g = random_grid(rng, cols, rows, 0, 0, 0, rng() % cols, rows - 1, rng() % cols);
+    }
+    const uint64_t expected = semiring_paths<CountSemiring<uint64_t>, VectorConfig>(g);
+    EXPECT_EQ(expected, count_paths_mirrored<VectorConfig>(g)) << i << ": " << g.codes();
+  }
+}
+
+// cols x rows of rooms, the intake and the AC at the given cells
+Grid open_grid(int cols, int rows, int start, int end) {
+  ostringstream text;
+  text << cols << " " << rows;
+  for(int cell = 0; cell < cols * rows; ++cell) {
+    text << " " << (cell == start ? 2 : cell == end ? 3 : 0);
+  }
+  return parse(text.str());
+}
+
+// the most states the plain sweep carries after a row
+size_t max_states(const Grid &g) {
+  vector<Grid::Node::degree_t> target_degrees;
+  vector<vector<Grid::Node> > next_neighbors;
+  unordered_set<VectorConfig> cur_configs{VectorConfig(vector<int>(g.cols, 0))}, next_configs;
+  size_t most = 0;
+  for(auto row : range(g.rows)) {
+    row_setup(g, row, target_degrees, next_neighbors);
+    for(auto &config : cur_configs) {
+      for_each_next_config<VectorConfig>(row, config, target_degrees, next_neighbors,
+	[&](const VectorConfig &next_config) { next_configs.insert(next_config); });
+    }
+    swap(cur_configs, next_configs);
+    next_configs.clear();
+    most = max(most, cur_configs.size());
+  }
+  return most;
+}
+
+TEST(Symmetry, open_grids_fold) {
+  // the intake top middle, the AC bottom middle
+  const Grid g = open_grid(7, 6, 3, 38);
+  MirrorSweep<VectorConfig> sweep(g);
+  EXPECT_EQ((semiring_paths<CountSemiring<uint64_t>, VectorConfig>(g)), sweep.run());
+  EXPECT_EQ(6u, sweep.paired_rows);
+  EXPECT_LT(sweep.max_states, max_states(g) * 6 / 10);
+
+  // the intake off the axis: the rows below it fold
+  const Grid skewed = open_grid(7, 6, 0, 38);
+  MirrorSweep<VectorConfig> merged(skewed);
+  EXPECT_EQ((semiring_paths<CountSemiring<uint64_t>, VectorConfig>(skewed)), merged.run());
+  EXPECT_EQ(0u, merged.paired_rows);
+  EXPECT_EQ(5u, merged.merged_rows);
+  EXPECT_LT(merged.max_states, max_states(skewed) * 6 / 10);
+}
@@ -0,0 +1,41 @@
+#ifndef __TEST_GRIDS_HH__
+#define __TEST_GRIDS_HH__
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "configuration.hh"
+#include "grid.hh"
+using namespace std;
+
+// What the tests have in common: the configuration they sweep with, grids
+// from text and the grids they keep coming back to.
+
+typedef Configuration<vector<unsigned short>, no_size_t> VectorConfig;
+
+inline Grid parse(const string &text) {
+  istringstream is(text);
+  Grid g(0, 0);
+  string error;
+  EXPECT_TRUE(read_grid(is, g, error)) << error << " in " << text;
+  return g;
+}
+
+// hard.quora, 301716 layouts
+const string hard_grid =
+  "7 8  2 0 0 0 0 0 0  0 0 0 0 0 0 0  0 0 0 0 0 0 0  0 0 0 0 0 0 0"
+  "  0 0 0 0 0 0 0  0 0 0 0 0 0 0  0 0 0 0 0 0 0  3 0 0 0 0 1 1";
+
+// cols x rows of rooms, the intake top left and the AC bottom right
+inline Grid open_grid(int cols, int rows) {
+  ostringstream text;
+  text << cols << " " << rows << " 2";
+  for(int cell = 2; cell < cols * rows; ++cell) {
+    text << " 0";
+  }
+  text << " 3";
+  return parse(text.str());
+}
+
+
+#endif
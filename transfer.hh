@@ -0,0 +1,197 @@
+#ifndef __TRANSFER_HH__
+#define __TRANSFER_HH__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "count_paths.hh"
+using namespace std;
+
+// Transfer-matrix powering.  A row's transition depends only on its own
+// cells and on which cells of the next row exist, its profile, so a run of
+// rows with one profile applies the same transfer matrix over and over.
+// For such a run the matrix is built once, over every state reachable
+// from the run's first states, and the state vector is multiplied by its
+// power, found by repeated squaring: log2 of the run's length matrix
+// products instead of one sweep per row.  Other rows, and runs whose
+// reachable states are too many to square, are swept one at a time.
+//
+// Counts are taken modulo modulus, or modulo 2^64 when it is zero.
+
+// arithmetic modulo m, or modulo 2^64 for m == 0
+struct Modular {
+  uint64_t m;
+
+  uint64_t reduce(uint64_t a) const { return m ? a % m : a; }
+  uint64_t plus(uint64_t a, uint64_t b) const {
+    if (not m)
+      return a + b;
+    const uint64_t sum = a + b;
+    return sum < a or sum >= m ? sum - m : sum;
+  }
+  uint64_t times(uint64_t a, uint64_t b) const {
+    return m ? (uint64_t)((unsigned __int128)a * b % m) : a * b;
+  }
+};
+
+// the cells of the row and the existence of those below it
+inline string row_profile(const Grid &g, const string &codes, size_t row) {
+  string profile = codes.substr(row * g.cols, g.cols);
+  for(auto col : range(g.cols)) {
+    profile += row + 1 == g.rows ? '-' : codes[(row + 1) * g.cols + col] == '1' ? '1' : '0';
+  }
+  return profile;
+}
+
+// runs shorter than this are swept row by row
+const size_t min_power_run = 3;
+// nor are the matrices of runs with more reachable states squared
+const size_t max_power_states = 256;
+
+template<class ConfigurationT>
+class TransferPower {
+  typedef unordered_map<ConfigurationT, uint64_t> config_map_t;
+
+  const Grid &g;
+  const Modular mod;
+  vector<Grid::Node::degree_t> target_degrees;
+  vector<vector<Grid::Node> > next_neighbors;
+
+  void step(size_t row, config_map_t &cur_configs) {
+    config_map_t next_configs;
+    for(auto &config_count : cur_configs) {
+      const uint64_t count = config_count.second;
+      for_each_next_config<ConfigurationT>(row, config_count.first, target_degrees, next_neighbors,
+        [&](const ConfigurationT &next_config) {
+	  uint64_t &next_count = next_configs[next_config];
+	  next_count = mod.plus(next_count, count);
+	});
+    }
+    swap(cur_configs, next_configs);
+  }
+
+  // n x n, row major
+  vector<uint64_t> multiply(const vector<uint64_t> &a, const vector<uint64_t> &b, size_t n) const {
+    vector<uint64_t> c(n * n, 0);
+    for(size_t i = 0; i < n; ++i) {
+      for(size_t k = 0; k < n; ++k) {
+	const uint64_t a_ik = a[i * n + k];
+	if (a_ik == 0)
+	  continue;
+	for(size_t j = 0; j < n; ++j) {
+	  c[i * n + j] = mod.plus(c[i * n + j], mod.times(a_ik, b[k * n + j]));
+	}
+      }
+    }
+    return c;
+  }
+
+  // cur_configs times the transfer matrix of row to the power of rows;
+  // false, leaving cur_configs alone, if there are too many states
+  bool power(size_t row, size_t rows, config_map_t &cur_configs) {
+    // the states reachable from cur_configs, and the matrix over them
+    vector<ConfigurationT> states;
+    unordered_map<ConfigurationT, size_t> index;
+    for(auto &config_count : cur_configs) {
+      index.insert(make_pair(config_count.first, states.size()));
+      states.push_back(config_count.first);
+    }
+    vector<vector<pair<size_t, uint64_t> > > transitions;
+    for(size_t i = 0; i < states.size(); ++i) {
+      if (states.size() > max_power_states)
+	return false;
+      unordered_map<size_t, uint64_t> successors;
+      const ConfigurationT state(states[i]);  // states grows below
+      for_each_next_config<ConfigurationT>(row, state, target_degrees, next_neighbors,
+        [&](const ConfigurationT &next_config) {
+	  auto found = index.find(next_config);
+	  if (found == index.end()) {
+	    found = index.insert(make_pair(next_config, states.size())).first;
+	    states.push_back(next_config);
+	  }
+	  ++successors[found->second];
+	});
+      transitions.push_back(vector<pair<size_t, uint64_t> >(successors.begin(), successors.end()));
+    }
+
+    const size_t n = states.size();
+    vector<uint64_t> matrix(n * n, 0), vec(n, 0);
+    for(size_t i = 0; i < n; ++i) {
+      for(auto &successor : transitions[i]) {
+	matrix[i * n + successor.first] = mod.reduce(successor.second);
+      }
+    }
+    for(auto &config_count : cur_configs) {
+      vec[index[config_count.first]] = config_count.second;
+    }
+
+    for(size_t k = rows; k > 0; k >>= 1) {
+      if (k & 1) {
+	vector<uint64_t> next(n, 0);
+	for(size_t i = 0; i < n; ++i) {
+	  if (vec[i] == 0)
+	    continue;
+	  for(size_t j = 0; j < n; ++j) {
+	    next[j] = mod.plus(next[j], mod.times(vec[i], matrix[i * n + j]));
+	  }
+	}
+	swap(vec, next);
+      }
+      if (k > 1)
+	matrix = multiply(matrix, matrix, n);
+    }
+
+    cur_configs.clear();
+    for(size_t i = 0; i < n; ++i) {
+      if (vec[i] != 0)
+	cur_configs[states[i]] = vec[i];
+    }
+    return true;
+  }
+
+public:
+  size_t powered_rows;  // rows handled by a matrix power
+
+  TransferPower(const Grid &g_, uint64_t modulus) : g(g_), mod({modulus}), powered_rows(0) {}
+
+  uint64_t run() {
+    const string codes = g.codes();
+    config_map_t cur_configs;
+    cur_configs[ConfigurationT(vector<int>(g.cols, 0))] = mod.reduce(1);
+
+    size_t row = 0;
+    while (row < g.rows) {
+      const string profile = row_profile(g, codes, row);
+      size_t run = 1;
+      while (row + run < g.rows and row_profile(g, codes, row + run) == profile)
+	++run;
+
+      row_setup(g, row, target_degrees, next_neighbors);
+      if (run >= min_power_run and power(row, run, cur_configs)) {
+	powered_rows += run;
+      } else {
+	for(size_t i = 0; i < run; ++i) {
+	  row_setup(g, row + i, target_degrees, next_neighbors);
+	  step(row + i, cur_configs);
+	}
+      }
+      row += run;
+    }
+
+    uint64_t total = mod.reduce(0);
+    for(auto &config_count : cur_configs) {
+      total = mod.plus(total, config_count.second);
+    }
+    return total;
+  }
+};
+
+template<class ConfigurationT>
+uint64_t count_paths_powered(const Grid &g, uint64_t modulus) {
+  return TransferPower<ConfigurationT>(g, modulus).run();
+}
+
+
+#endif
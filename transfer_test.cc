@@ -0,0 +1,55 @@
+#include "transfer.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <sstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+// cols x rows, start top left, end bottom right, with a pillar at col 1
+// of every fourth row when pillars is set
+Grid tall_grid(int cols, int rows, bool pillars) {
+  ostringstream text;
+  text << cols << " " << rows;
+  for(int row = 0; row < rows; ++row) {
+    for(int col = 0; col < cols; ++col) {
+      const bool first = row == 0 and col == 0, last = row == rows - 1 and col == cols - 1;
+      text << " " << (first ? 2 : last ? 3 : pillars and col == 1 and row % 4 == 2 ? 1 : 0);
+    }
+  }
+  return parse(text.str());
+}
+
+TEST(Transfer, powers_match_the_sweep) {
+  for(int cols : {2, 3, 4, 5}) {
+    for(int rows : {1, 2, 5, 8, 13, 40}) {
+      for(bool pillars : {false, true}) {
+	const Grid g = tall_grid(cols, rows, pillars);
+	const uint64_t expected = semiring_paths<CountSemiring<uint64_t>, VectorConfig>(g);
+	TransferPower<VectorConfig> power(g, 0);
+	EXPECT_EQ(expected, power.run()) << cols << "x" << rows << " " << pillars;
+	if (not pillars and rows >= 8) {
+	  EXPECT_EQ((size_t)rows - 2, power.powered_rows);
+	}
+      }
+    }
+  }
+
+  Grid hard = parse(hard_grid);
+  EXPECT_EQ(301716u, count_paths_powered<VectorConfig>(hard, 0));
+}
+
+TEST(Transfer, modular_counts) {
+  const uint64_t p = 1000000007;
+  const Grid g = tall_grid(4, 30, false);
+  const uint64_t full = semiring_paths<CountSemiring<uint64_t>, VectorConfig>(g);
+  ASSERT_LT(full, (uint64_t)1 << 62);
+  EXPECT_EQ(full % p, count_paths_powered<VectorConfig>(g, p));
+  EXPECT_EQ(full % 97, count_paths_powered<VectorConfig>(g, 97));
+
+  // counts far past 2^64 wrap alike
+  const Grid corridor = tall_grid(4, 250, false);
+  EXPECT_EQ((semiring_paths<CountSemiring<uint64_t>, VectorConfig>(corridor)),
+	    count_paths_powered<VectorConfig>(corridor, 0));
+}
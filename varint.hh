@@ -0,0 +1,62 @@
+#ifndef __VARINT_HH__
+#define __VARINT_HH__
+
+#include <iostream>
+#include <stdint.h>
+using namespace std;
+
+// LEB128 varints for the binary file formats and the frozen frontier
+// tables.
+
+inline void put_varint(ostream &os, uint64_t value) {
+  while (value >= 0x80) {
+    os.put((char)(value | 0x80));
+    value >>= 7;
+  }
+  os.put((char)value);
+}
+
+inline bool get_varint(istream &is, uint64_t &value) {
+  value = 0;
+  for(int shift = 0; shift < 64; shift += 7) {
+    int c = is.get();
+    if (c == EOF)
+      return false;
+    value |= (uint64_t)(c & 0x7f) << shift;
+    if (not (c & 0x80))
+      return true;
+  }
+  return false;
+}
+
+
+inline size_t varint_size(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+// appends value to a byte container
+template<class Bytes>
+inline void append_varint(Bytes &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+}
+
+// decodes a varint written by append_varint and returns what follows it
+inline const uint8_t *read_varint(const uint8_t *p, uint64_t &value) {
+  value = *p & 0x7f;
+  for(int shift = 7; *p++ & 0x80; shift += 7) {
+    value |= (uint64_t)(*p & 0x7f) << shift;
+  }
+  return p;
+}
+
+
+#endif
@@ -7,6 +7,11 @@
 #include <iostream>
 #include "range.hh"
 
+template<class T, class V>
+ostream &operator<<(ostream &os, const pair<T,V> &things);
+template<class... Ts>
+ostream &operator<<(ostream &os, const tuple<Ts...> &things);
+
 template<class T>  
 ostream &operator<<(ostream &os, const vector<T> &things) {
   bool first = true;
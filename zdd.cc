@@ -0,0 +1,199 @@
+#include "zdd.hh"
+
+#include <algorithm>
+#include <limits>
+#include "varint.hh"
+
+namespace {
+  const char magic[4] = {'H', 'Z', 'D', 'D'};
+  const uint8_t format_version = 1;
+}
+
+const Zdd::node_t Zdd::bottom;
+const Zdd::node_t Zdd::top;
+const Zdd::node_t Zdd::unset;
+
+Zdd::Zdd(const vector<FrontierPlan::Edge> &edges) :
+  edges(edges),
+  nodes{{(var_t)edges.size(), bottom, bottom}, {(var_t)edges.size(), top, top}},
+  root(bottom)
+{}
+
+Zdd::node_t Zdd::make_node(var_t var, node_t lo, node_t hi) {
+  assert(var < edges.size());
+  assert(lo < nodes.size() and hi < nodes.size());
+  assert(nodes[lo].var > var and nodes[hi].var > var);
+
+  if (hi == bottom)
+    return lo;
+
+  Node n({var, lo, hi});
+  auto inserted = unique.insert(make_pair(n, (node_t)nodes.size()));
+  if (inserted.second) {
+    nodes.push_back(n);
+  }
+  return inserted.first->second;
+}
+
+size_t Zdd::size() const {
+  vector<bool> reachable(nodes.size(), false);
+  reachable[root] = true;
+  size_t out = 0;
+  for(size_t id = nodes.size(); id-- > 2; ) {
+    if (reachable[id]) {
+      ++out;
+      reachable[nodes[id].lo] = reachable[nodes[id].hi] = true;
+    }
+  }
+  return out;
+}
+
+vector<uint64_t> Zdd::counts() const {
+  vector<uint64_t> out(nodes.size(), 0);
+  out[top] = 1;
+  for(size_t id = 2; id < nodes.size(); ++id) {
+    out[id] = out[nodes[id].lo] + out[nodes[id].hi];
+  }
+  return out;
+}
+
+uint64_t Zdd::count() const {
+  return counts()[root];
+}
+
+Zdd::node_t Zdd::copy(node_t node, Zdd &out, vector<node_t> &memo) const {
+  if (node == bottom or node == top)
+    return node;
+  if (memo[node] == unset) {
+    const Node &n = nodes[node];
+    memo[node] = out.make_node(n.var, copy(n.lo, out, memo), copy(n.hi, out, memo));
+  }
+  return memo[node];
+}
+
+Zdd::node_t Zdd::restrict(var_t var, bool value, node_t node, Zdd &out,
+			  vector<node_t> &memo, vector<node_t> &copied) const {
+  const Node &n = nodes[node];
+  if (n.var > var) // covers the terminals: var cannot occur below
+    return value ? bottom : copy(node, out, copied);
+
+  if (memo[node] == unset) {
+    if (n.var == var) {
+      memo[node] = value ?
+	out.make_node(var, bottom, copy(n.hi, out, copied)) :
+	copy(n.lo, out, copied);
+    } else {
+      node_t lo = restrict(var, value, n.lo, out, memo, copied);
+      node_t hi = restrict(var, value, n.hi, out, memo, copied);
+      memo[node] = out.make_node(n.var, lo, hi);
+    }
+  }
+  return memo[node];
+}
+
+Zdd Zdd::require(var_t var) const {
+  Zdd out(edges);
+  vector<node_t> memo(nodes.size(), unset), copied(nodes.size(), unset);
+  out.root = restrict(var, true, root, out, memo, copied);
+  return out;
+}
+
+Zdd Zdd::forbid(var_t var) const {
+  Zdd out(edges);
+  vector<node_t> memo(nodes.size(), unset), copied(nodes.size(), unset);
+  out.root = restrict(var, false, root, out, memo, copied);
+  return out;
+}
+
+vector<Zdd::var_t> Zdd::sample(mt19937_64 &rng) const {
+  const vector<uint64_t> count = counts();
+  assert(count[root] > 0);
+
+  vector<var_t> out;
+  node_t node = root;
+  while (node != top) {
+    const Node &n = nodes[node];
+    uniform_int_distribution<uint64_t> pick(0, count[node] - 1);
+    if (pick(rng) < count[n.hi]) {
+      out.push_back(n.var);
+      node = n.hi;
+    } else {
+      node = n.lo;
+    }
+  }
+  return out;
+}
+
+Zdd::var_t Zdd::edge_var(Grid::Node::index_t a, Grid::Node::index_t b) const {
+  for(auto var : range(edges.size())) {
+    if ((edges[var].a == a and edges[var].b == b) or
+	(edges[var].a == b and edges[var].b == a))
+      return var;
+  }
+  return edges.size();
+}
+
+// Layout: magic, version, edge list, node count, root, then each
+// nonterminal in id order as its var and the distances back to its
+// children, all as LEB128 varints.
+void Zdd::save(ostream &os) const {
+  os.write(magic, sizeof(magic));
+  os.put((char)format_version);
+
+  put_varint(os, edges.size());
+  for(auto &e : edges) {
+    put_varint(os, e.a);
+    put_varint(os, e.b);
+  }
+
+  put_varint(os, nodes.size() - 2);
+  put_varint(os, root);
+  for(size_t id = 2; id < nodes.size(); ++id) {
+    put_varint(os, nodes[id].var);
+    put_varint(os, id - nodes[id].lo);
+    put_varint(os, id - nodes[id].hi);
+  }
+}
+
+bool Zdd::load(istream &is, Zdd &out) {
+  char header[sizeof(magic)];
+  if (not is.read(header, sizeof(header)) or not equal(header, header + sizeof(magic), magic))
+    return false;
+  if (is.get() != format_version)
+    return false;
+
+  uint64_t num_edges, num_nodes, root, a, b;
+  if (not get_varint(is, num_edges))
+    return false;
+
+  vector<FrontierPlan::Edge> edges;
+  for(uint64_t i = 0; i < num_edges; ++i) {
+    if (not get_varint(is, a) or not get_varint(is, b) or
+	a > numeric_limits<Grid::Node::index_t>::max() or
+	b > numeric_limits<Grid::Node::index_t>::max())
+      return false;
+    edges.push_back(FrontierPlan::Edge({(Grid::Node::index_t)a, (Grid::Node::index_t)b}));
+  }
+
+  Zdd zdd(edges);
+  if (not get_varint(is, num_nodes) or not get_varint(is, root) or root >= num_nodes + 2)
+    return false;
+
+  for(uint64_t id = 2; id < num_nodes + 2; ++id) {
+    uint64_t var, lo, hi;
+    if (not get_varint(is, var) or not get_varint(is, lo) or not get_varint(is, hi))
+      return false;
+    if (var >= num_edges or lo == 0 or hi == 0 or lo > id or hi > id)
+      return false;
+    lo = id - lo;
+    hi = id - hi;
+    if (zdd.nodes[lo].var <= var or zdd.nodes[hi].var <= var or hi == bottom)
+      return false;
+    if (zdd.make_node(var, lo, hi) != id)
+      return false; // not reduced
+  }
+
+  zdd.root = root;
+  swap(out, zdd);
+  return true;
+}
@@ -0,0 +1,199 @@
+#ifndef __ZDD_HH__
+#define __ZDD_HH__
+
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <random>
+#include <cassert>
+#include <stdint.h>
+
+#include "frontier.hh"
+#include "range.hh"
+using namespace std;
+
+// A reduced zero-suppressed decision diagram over the edges of a
+// FrontierPlan.  Each accepted edge set is one Hamiltonian path.  Node 0 is
+// the empty family, node 1 the family holding only the empty set; every
+// other node's children have smaller ids, so id order is a topological
+// order from the terminals up.
+struct Zdd {
+  typedef uint32_t node_t;
+  typedef FrontierPlan::edge_t var_t;
+
+  static const node_t bottom = 0;
+  static const node_t top = 1;
+  static const node_t unset = 0xffffffff;
+
+  struct Node {
+    var_t var;
+    node_t lo, hi;
+
+    friend bool operator==(const Node &a, const Node &b) {
+      return a.var == b.var and a.lo == b.lo and a.hi == b.hi;
+    }
+  };
+
+  struct NodeHash {
+    size_t operator()(const Node &n) const {
+      uint64_t h = n.var;
+      h = h * 0x9e3779b97f4a7c15ull + n.lo;
+      h = h * 0x9e3779b97f4a7c15ull + n.hi;
+      return h ^ (h >> 29);
+    }
+  };
+
+  vector<FrontierPlan::Edge> edges; // indexed by var
+  vector<Node> nodes;
+  node_t root;
+
+  Zdd(const vector<FrontierPlan::Edge> &edges);
+
+  node_t make_node(var_t var, node_t lo, node_t hi);
+
+  // number of nonterminal nodes reachable from the root
+  size_t size() const;
+
+  uint64_t count() const;
+
+  // subfamilies of the paths that use / avoid the edge
+  Zdd require(var_t var) const;
+  Zdd forbid(var_t var) const;
+
+  // a uniformly random member, as its edge vars; the family must be nonempty
+  vector<var_t> sample(mt19937_64 &rng) const;
+
+  // the var joining vertices a and b, or edges.size() if there is none
+  var_t edge_var(Grid::Node::index_t a, Grid::Node::index_t b) const;
+
+  void save(ostream &os) const;
+  static bool load(istream &is, Zdd &out);
+
+private:
+  unordered_map<Node, node_t, NodeHash> unique;
+
+  vector<uint64_t> counts() const;
+  node_t copy(node_t node, Zdd &out, vector<node_t> &memo) const;
+  node_t restrict(var_t var, bool value, node_t node, Zdd &out,
+		  vector<node_t> &memo, vector<node_t> &copied) const;
+};
+
+
+namespace zdd_detail {
+  // the configuration before a step, plus the out edges chosen so far
+  template<class ConfigurationT>
+  struct State {
+    ConfigurationT config;
+    uint32_t chosen;
+
+    friend bool operator==(const State &a, const State &b) {
+      return a.chosen == b.chosen and a.config == b.config;
+    }
+  };
+
+  template<class ConfigurationT>
+  struct StateHash {
+    size_t operator()(const State<ConfigurationT> &s) const {
+      return hash<ConfigurationT>()(s.config) ^ (s.chosen * 0x9e3779b97f4a7c15ull);
+    }
+  };
+}
+
+// Frontier-based top-down construction followed by bottom-up reduction
+// through the unique table.  States are merged per variable, so the
+// intermediate diagram is already shared; reduction only drops the nodes
+// whose hi edge is dead and merges equal children.
+template<class ConfigurationT>
+Zdd build_zdd(const FrontierPlan &plan) {
+  typedef zdd_detail::State<ConfigurationT> state_t;
+  typedef unordered_map<state_t, Zdd::node_t, zdd_detail::StateHash<ConfigurationT> > level_t;
+
+  const size_t num_vars = plan.edges.size();
+
+  // var -> (step, position within step.out_edges)
+  vector<pair<size_t, size_t> > var_step(num_vars);
+  for(auto s : range(plan.steps.size())) {
+    const auto &out = plan.steps[s].out_edges;
+    for(auto i : range(out.size())) {
+      var_step[out[i]] = make_pair(s, i);
+    }
+  }
+
+  vector<Zdd::Node> raw{{0, 0, 0}, {0, 1, 1}}; // terminals, then unreduced nodes
+  vector<level_t> levels(num_vars);
+  vector< vector<Zdd::node_t> > by_var(num_vars);
+
+  const auto intern = [&](Zdd::var_t var, const state_t &state) -> Zdd::node_t {
+    auto inserted = levels[var].insert(make_pair(state, (Zdd::node_t)raw.size()));
+    if (inserted.second) {
+      raw.push_back(Zdd::Node({var, 0, 0}));
+      by_var[var].push_back(inserted.first->second);
+    }
+    return inserted.first->second;
+  };
+
+  // runs through vertices without out edges up to the next variable
+  const auto enter = [&](ConfigurationT config, size_t s) -> Zdd::node_t {
+    for(; s < plan.steps.size(); ++s) {
+      const auto &step = plan.steps[s];
+      if (not step.out_edges.empty()) {
+	return intern(step.out_edges[0], state_t({config, 0}));
+      }
+      if (not frontier_step(config, step, 0)) {
+	return Zdd::bottom;
+      }
+    }
+    return frontier_empty(config) ? Zdd::top : Zdd::bottom;
+  };
+
+  const Zdd::node_t raw_root = enter(ConfigurationT(vector<int>(plan.slots, 0)), 0);
+
+  for(auto var : range(num_vars)) {
+    const auto &step = plan.steps[var_step[var].first];
+    const size_t pos = var_step[var].second;
+    const int remaining = step.out_edges.size() - pos - 1;
+
+    for(auto &entry : levels[var]) {
+      const state_t &state = entry.first;
+      const int in = frontier_in_degree(state.config, step);
+
+      Zdd::node_t children[2];
+      for(uint32_t take : {0, 1}) {
+	const uint32_t chosen = state.chosen | (take << pos);
+	const int degree = in + __builtin_popcount(chosen);
+	Zdd::node_t &child = children[take];
+
+	if (degree > step.target_degree or degree + remaining < step.target_degree) {
+	  child = Zdd::bottom;
+	} else if (remaining > 0) {
+	  child = intern(var + 1, state_t({state.config, chosen}));
+	} else {
+	  ConfigurationT next(state.config);
+	  child = frontier_step(next, step, chosen) ?
+	    enter(next, var_step[var].first + 1) : Zdd::bottom;
+	}
+      }
+
+      raw[entry.second].lo = children[0];
+      raw[entry.second].hi = children[1];
+    }
+
+    level_t().swap(levels[var]);
+  }
+
+  Zdd zdd(plan.edges);
+  vector<Zdd::node_t> reduced(raw.size(), Zdd::bottom);
+  reduced[Zdd::top] = Zdd::top;
+
+  for(size_t var = num_vars; var-- > 0; ) {
+    for(auto id : by_var[var]) {
+      reduced[id] = zdd.make_node(var, reduced[raw[id].lo], reduced[raw[id].hi]);
+    }
+  }
+
+  zdd.root = reduced[raw_root];
+  return zdd;
+}
+
+
+#endif
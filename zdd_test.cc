@@ -0,0 +1,87 @@
+#include "zdd.hh"
+#include "count_paths.hh"
+#include "gtest/gtest.h"
+#include "test_grids.hh"
+
+#include <sstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+const vector<string> grids {
+  "4 3  2 0 0 0  0 0 0 0  0 0 3 1",
+  "3 4  2 0 0  0 0 0  0 0 3  0 0 1",
+  "5 4  2 0 0 0 0  0 0 0 0 0  0 0 0 0 0  3 0 0 0 0",
+  "5 5  2 0 0 0 0  0 1 0 0 0  0 0 0 1 0  0 0 0 0 0  1 0 0 0 3",
+  "6 5  0 0 0 0 0 0  0 2 0 0 0 0  0 0 1 1 0 0  0 0 0 0 3 0  0 0 0 0 0 0",
+  "3 3  2 1 0  1 0 0  0 0 3",
+};
+
+Zdd build(const Grid &g) {
+  return build_zdd<VectorConfig>(FrontierPlan(g));
+}
+
+TEST(Zdd, count_matches_sweep) {
+  for(auto text : grids) {
+    Grid g = parse(text);
+    EXPECT_EQ((uint64_t)count_paths<VectorConfig>(g), build(g).count()) << text;
+  }
+}
+
+TEST(Zdd, conditioning_partitions) {
+  for(auto text : grids) {
+    Zdd zdd = build(parse(text));
+    for(Zdd::var_t var = 0; var < zdd.edges.size(); ++var) {
+      EXPECT_EQ(zdd.count(), zdd.require(var).count() + zdd.forbid(var).count());
+    }
+  }
+
+  Grid g = parse(grids[0]);
+  Zdd zdd = build(g);
+  // the two paths of the readme differ in whether (0,0)-(0,1) is used
+  Zdd::var_t first = zdd.edge_var(g.index(0, 0), g.index(0, 1));
+  ASSERT_LT(first, zdd.edges.size());
+  EXPECT_EQ(1u, zdd.require(first).count());
+  EXPECT_EQ(1u, zdd.forbid(first).count());
+  EXPECT_EQ(0u, zdd.require(first).forbid(first).count());
+}
+
+TEST(Zdd, save_load_round_trip) {
+  for(auto text : grids) {
+    Zdd zdd = build(parse(text));
+    ostringstream os;
+    zdd.save(os);
+
+    Zdd loaded(vector<FrontierPlan::Edge>{});
+    istringstream is(os.str());
+    ASSERT_TRUE(Zdd::load(is, loaded));
+    EXPECT_EQ(zdd.count(), loaded.count());
+    EXPECT_EQ(zdd.size(), loaded.size());
+    EXPECT_EQ(zdd.edges.size(), loaded.edges.size());
+  }
+
+  Zdd junk(vector<FrontierPlan::Edge>{});
+  istringstream is("HZDD\x01\x05");
+  EXPECT_FALSE(Zdd::load(is, junk));
+}
+
+TEST(Zdd, samples_are_paths) {
+  mt19937_64 rng(1);
+  for(auto text : grids) {
+    Grid g = parse(text);
+    Zdd zdd = build(g);
+    if (zdd.count() == 0)
+      continue;
+
+    for(int i = 0; i < 20; ++i) {
+      vector<int> degree(g.nodes.size(), 0);
+      for(auto var : zdd.sample(rng)) {
+	++degree[zdd.edges[var].a];
+	++degree[zdd.edges[var].b];
+      }
+      for(auto idx : range(g.nodes.size())) {
+	EXPECT_EQ(g.nodes[idx].target_degree, degree[idx]);
+      }
+    }
+  }
+}